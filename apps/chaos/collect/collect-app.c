@@ -44,6 +44,7 @@
 #include "chaos-control.h"
 #include "node.h"
 #include "chaos-collect.h"
+#include "chaos-multichannel.h"
 
 static collect_value_t collect_value = 0;
 static collect_value_t* collect_value_store = NULL;
@@ -97,6 +98,16 @@ PROCESS_THREAD(chaos_collect_app_process, ev, data)
   //      printf(" %lu", (uint32_t)collect_value_store[i]);
   //    }
   //    printf("\n");
+#if CHAOS_MULTI_CHANNEL && CHAOS_CHANNEL_STATS
+      /* network-wide per-channel link summary, see chaos_multichannel_get_stats_summary() */
+      if(complete){
+        printf("{rd %u chs}", round_count_local);
+        for( i = 0; i < chaos_node_count; i++ ){
+          printf(" %04x", collect_value_store[i]);
+        }
+        printf("\n");
+      }
+#endif /* CHAOS_MULTI_CHANNEL && CHAOS_CHANNEL_STATS */
     } else {
       printf("{rd %u res} collect: waiting to join, n: %u\n", round_count_local, chaos_node_count);
     }
@@ -105,7 +116,11 @@ PROCESS_THREAD(chaos_collect_app_process, ev, data)
 }
 
 static void round_begin(const uint16_t round_count, const uint8_t id) {
+#if CHAOS_MULTI_CHANNEL && CHAOS_CHANNEL_STATS
+  collect_value = chaos_multichannel_get_stats_summary(round_count);
+#else
   collect_value = chaos_node_index;
+#endif /* CHAOS_MULTI_CHANNEL && CHAOS_CHANNEL_STATS */
   collect_value_store = &collect_value;
   complete = chaos_collect_round_begin(round_count, id, &collect_value_store, &flags);
   off_slot = chaos_collect_get_off_slot();
@@ -56,6 +56,32 @@
 #define CHAOS_LOG_FLAGS 1
 #endif
 
+/* store the logged flags as changed bytes against the previous log entry in a shared
+ * byte pool, with a full keyframe every CHAOS_LOG_FLAGS_KEYFRAME entries and per round */
+#ifndef CHAOS_LOG_FLAGS_DELTA
+#define CHAOS_LOG_FLAGS_DELTA 0
+#endif /* CHAOS_LOG_FLAGS_DELTA */
+
+#ifndef CHAOS_LOG_FLAGS_KEYFRAME
+#define CHAOS_LOG_FLAGS_KEYFRAME 32
+#endif /* CHAOS_LOG_FLAGS_KEYFRAME */
+
+/* bytes of the flag pool, power of two */
+#ifndef CHAOS_LOG_FLAGS_POOL_SIZE
+#define CHAOS_LOG_FLAGS_POOL_SIZE 512
+#endif /* CHAOS_LOG_FLAGS_POOL_SIZE */
+
+/* print the app, slot count and slot length of every round for tools/chaos/chaos-timeline.py */
+#ifndef CHAOS_TIMELINE
+#define CHAOS_TIMELINE 0
+#endif /* CHAOS_TIMELINE */
+
+/* drain the slot log as SLIP-framed varint records instead of text lines,
+ * decode on the host with tools/chaos/chaos-log-decode */
+#ifndef CHAOS_LOG_BINARY
+#define CHAOS_LOG_BINARY 0
+#endif /* CHAOS_LOG_BINARY */
+
 #if CHAOS_DEBUG_PRINTF
 #include "stdio.h"
 #define PRINTF(...) printf(__VA_ARGS__)
@@ -83,6 +109,205 @@
 #define RX_GUARD_TIME (10) /* rtimer ticks per slot */
 #define ROUND_GUARD_TIME ((RTIMER_SECOND/1000))
 
+/* estimate the clock drift across rounds to predict the next round start
+ * and shrink the round guard accordingly (non-initiators only) */
+#ifndef CHAOS_DRIFT_COMPENSATION
+#define CHAOS_DRIFT_COMPENSATION 0
+#endif /* CHAOS_DRIFT_COMPENSATION */
+
+/* keep following the predicted round schedule (timing, drift correction and channel hopping)
+ * for CHAOS_FAST_RESYNC_ROUNDS extra failed rounds before falling back to a full association scan.
+ * The round guard doubles with every failed round, up to CHAOS_FAST_RESYNC_MAX_GUARD */
+#ifndef CHAOS_FAST_RESYNC
+#define CHAOS_FAST_RESYNC 0
+#endif /* CHAOS_FAST_RESYNC */
+
+#ifndef CHAOS_FAST_RESYNC_ROUNDS
+#define CHAOS_FAST_RESYNC_ROUNDS (4)
+#endif /* CHAOS_FAST_RESYNC_ROUNDS */
+
+/* upper bound of the widened guard, below the usual 4-7 ms slot.
+ * The round-start listen is further limited to one slot length: a window of one slot
+ * catches a frame at any phase of the slot grid and the header carries the slot number */
+#ifndef CHAOS_FAST_RESYNC_MAX_GUARD
+#define CHAOS_FAST_RESYNC_MAX_GUARD ((RTIMER_SECOND/256))
+#endif /* CHAOS_FAST_RESYNC_MAX_GUARD */
+
+/* sleep in LPM0 during the idle part of a slot instead of busy waiting.
+ * The CPU is woken up CHAOS_LPM_WAKEUP_GUARD rtimer ticks before the end of the wait
+ * and busy waits for the remaining ticks. Falls back to busy waiting on platforms without support. */
+#ifndef CHAOS_LPM_BETWEEN_SLOTS
+#define CHAOS_LPM_BETWEEN_SLOTS 0
+#endif /* CHAOS_LPM_BETWEEN_SLOTS */
+
+#ifndef CHAOS_LPM_WAKEUP_GUARD
+#define CHAOS_LPM_WAKEUP_GUARD 2
+#endif /* CHAOS_LPM_WAKEUP_GUARD */
+
+/* check before every synced slot that the go-time of the slot can still be met.
+ * If the processing of the previous slot overran it, the slot is skipped instead of
+ * transmitting (or listening) late, and the overrun is counted per app */
+#ifndef CHAOS_SLOT_OVERRUN_DETECTION
+#define CHAOS_SLOT_OVERRUN_DETECTION 0
+#endif /* CHAOS_SLOT_OVERRUN_DETECTION */
+
+/* rtimer ticks reserved between the check and the tx/rx wait loop */
+#ifndef CHAOS_SLOT_OVERRUN_GUARD
+#define CHAOS_SLOT_OVERRUN_GUARD 2
+#endif /* CHAOS_SLOT_OVERRUN_GUARD */
+
+/* learn the final flood length (N_TX_COMPLETE) and the restart window (CHAOS_RESTART_MIN/MAX)
+ * of the apps online from the slot success rate and from how often a neighbor still
+ * lacks the final state after completion, see chaos-termination.h */
+#ifndef CHAOS_ADAPTIVE_TERMINATION
+#define CHAOS_ADAPTIVE_TERMINATION 0
+#endif /* CHAOS_ADAPTIVE_TERMINATION */
+
+/* shortest final flood, in tx slots */
+#ifndef CHAOS_ADAPTIVE_TERMINATION_N_TX_MIN
+#define CHAOS_ADAPTIVE_TERMINATION_N_TX_MIN 2
+#endif /* CHAOS_ADAPTIVE_TERMINATION_N_TX_MIN */
+
+/* calibrate the slot length of each app from measured slot timings.
+ * The configured slot length is used as an upper bound and before the first calibration;
+ * the initiator announces the calibrated value in the header */
+#ifndef CHAOS_SLOT_CALIBRATION
+#define CHAOS_SLOT_CALIBRATION 0
+#endif /* CHAOS_SLOT_CALIBRATION */
+
+/* co-initiators start each round concurrently with the initiator, using the
+ * schedule learnt in the previous round, so the round still starts when the
+ * initiator is far away or down.
+ * Define CHAOS_CO_INITIATOR_IDS as a comma-separated list of node ids to enable */
+#ifdef CHAOS_CO_INITIATOR_IDS
+#define CHAOS_CO_INITIATORS 1
+#else
+#define CHAOS_CO_INITIATORS 0
+#endif /* CHAOS_CO_INITIATOR_IDS */
+
+/* support rounds beyond 512 slots and networks beyond 255 nodes:
+ * adds one header byte (slot number bits 9-14 and node count bits 8-9),
+ * packs the slot log into nibbles and widens node indices, paxos ballots and the
+ * paxos flag statistics to 16 bits. A nibble holds the slot status up to 0xf:
+ * rx timeouts after 6 or more bytes (CHAOS_RX_TIMEOUT + bytes) all log as 0xf */
+#ifndef CHAOS_LARGE_SCALE
+#define CHAOS_LARGE_SCALE 0
+#endif /* CHAOS_LARGE_SCALE */
+
+/* compressed header profile: after the first CHAOS_HEADER_FULL_SLOTS slots, non-initiators
+ * omit the round-constant header fields and send a one-byte round hash (epoch) instead.
+ * A full header is still sent every CHAOS_HEADER_FULL_PERIOD slots so late nodes can sync */
+#ifndef CHAOS_HEADER_COMPRESSION
+#define CHAOS_HEADER_COMPRESSION 0
+#endif /* CHAOS_HEADER_COMPRESSION */
+
+#ifndef CHAOS_HEADER_FULL_SLOTS
+#define CHAOS_HEADER_FULL_SLOTS 4
+#endif /* CHAOS_HEADER_FULL_SLOTS */
+
+#ifndef CHAOS_HEADER_FULL_PERIOD
+#define CHAOS_HEADER_FULL_PERIOD 16
+#endif /* CHAOS_HEADER_FULL_PERIOD */
+
+/* let apps with a piggyback descriptor ride along in the rounds of other apps */
+#ifndef CHAOS_PIGGYBACK
+#define CHAOS_PIGGYBACK 0
+#endif /* CHAOS_PIGGYBACK */
+
+/* adaptive round interval: the initiator schedules rounds back-to-back while an app
+ * reports pending work (is_pending) and backs off towards CHAOS_ADAPTIVE_INTERVAL_MAX when idle */
+#ifndef CHAOS_ADAPTIVE_INTERVAL
+#define CHAOS_ADAPTIVE_INTERVAL 0
+#endif /* CHAOS_ADAPTIVE_INTERVAL */
+
+#ifndef CHAOS_ADAPTIVE_INTERVAL_MAX
+#define CHAOS_ADAPTIVE_INTERVAL_MAX CHAOS_INTERVAL
+#endif /* CHAOS_ADAPTIVE_INTERVAL_MAX */
+
+/* gap between back-to-back rounds (rtimer ticks): must cover post-processing, logging and pre-processing */
+#ifndef CHAOS_ADAPTIVE_INTERVAL_GAP
+#define CHAOS_ADAPTIVE_INTERVAL_GAP (RTIMER_SECOND/10)
+#endif /* CHAOS_ADAPTIVE_INTERVAL_GAP */
+
+/* split the work between rounds (log output, round report, random table) into small jobs
+ * that stop before the next round is due; the rest is deferred to later gaps */
+#ifndef CHAOS_BUDGETED_PROCESSING
+#define CHAOS_BUDGETED_PROCESSING 0
+#endif /* CHAOS_BUDGETED_PROCESSING */
+
+/* rtimer ticks kept free before the pre-processing of the next round */
+#ifndef CHAOS_BUDGETED_PROCESSING_GUARD
+#define CHAOS_BUDGETED_PROCESSING_GUARD (RTIMER_SECOND/200)
+#endif /* CHAOS_BUDGETED_PROCESSING_GUARD */
+
+/* job sizes: random table entries and log lines between two budget checks */
+#ifndef CHAOS_BUDGETED_PROCESSING_RANDOM_STEP
+#define CHAOS_BUDGETED_PROCESSING_RANDOM_STEP 32
+#endif /* CHAOS_BUDGETED_PROCESSING_RANDOM_STEP */
+
+#ifndef CHAOS_BUDGETED_PROCESSING_LOG_STEP
+#define CHAOS_BUDGETED_PROCESSING_LOG_STEP 2
+#endif /* CHAOS_BUDGETED_PROCESSING_LOG_STEP */
+
+/* per round and per app radio and CPU time, see chaos_get_energy_round() */
+#ifndef CHAOS_ENERGY_ACCOUNTING
+#define CHAOS_ENERGY_ACCOUNTING 0
+#endif /* CHAOS_ENERGY_ACCOUNTING */
+
+/* probe points (see chaos-probe.h): count, sum and max DCO ticks of kernel and app code spans,
+ * printed and cleared with every round report */
+#ifndef CHAOS_PROBES
+#define CHAOS_PROBES 0
+#endif /* CHAOS_PROBES */
+
+/* probe points available to apps, CHAOS_PROBE_APP(0..N-1) */
+#ifndef CHAOS_PROBES_APP_COUNT
+#define CHAOS_PROBES_APP_COUNT 4
+#endif /* CHAOS_PROBES_APP_COUNT */
+
+/* log-scale histograms of the slot timing phases per app, next to the min/max profile */
+#ifndef CHAOS_SLOT_TIMING_HISTOGRAM
+#define CHAOS_SLOT_TIMING_HISTOGRAM 0
+#endif /* CHAOS_SLOT_TIMING_HISTOGRAM */
+
+/* apps with their own histograms; apps with a higher id share the last one */
+#ifndef CHAOS_SLOT_TIMING_HISTOGRAM_APPS
+#define CHAOS_SLOT_TIMING_HISTOGRAM_APPS 2
+#endif /* CHAOS_SLOT_TIMING_HISTOGRAM_APPS */
+
+/* bucket 0: below 2^SHIFT DCO ticks, bucket b: [2^(SHIFT+b-1), 2^(SHIFT+b)), the last one is open */
+#ifndef CHAOS_SLOT_TIMING_HISTOGRAM_BUCKETS
+#define CHAOS_SLOT_TIMING_HISTOGRAM_BUCKETS 12
+#endif /* CHAOS_SLOT_TIMING_HISTOGRAM_BUCKETS */
+
+#ifndef CHAOS_SLOT_TIMING_HISTOGRAM_SHIFT
+#define CHAOS_SLOT_TIMING_HISTOGRAM_SHIFT 5
+#endif /* CHAOS_SLOT_TIMING_HISTOGRAM_SHIFT */
+
+/* rounds accumulated before the histograms are printed and cleared */
+#ifndef CHAOS_SLOT_TIMING_HISTOGRAM_ROUNDS
+#define CHAOS_SLOT_TIMING_HISTOGRAM_ROUNDS 1
+#endif /* CHAOS_SLOT_TIMING_HISTOGRAM_ROUNDS */
+
+/* maximum number of CHAOS_APPS: above 8, the header carries the high bits of the app ids
+ * in one extra byte (up to 128 apps) */
+#ifndef CHAOS_MAX_APPS
+#define CHAOS_MAX_APPS 8
+#endif /* CHAOS_MAX_APPS */
+
+/* initiator picks the next app by deadline and weighted fair share instead of the first pending app,
+ * see scheduler_set_policy() */
+#ifndef CHAOS_SCHEDULER_POLICY
+#define CHAOS_SCHEDULER_POLICY 0
+#endif /* CHAOS_SCHEDULER_POLICY */
+
+/* intervals between rounds beyond the 16-bit rtimer period: next_round_start is sent
+ * as a 12-bit tick count with a 4-bit scale exponent, and the round timer hops across
+ * rtimer overflows. Use 32-bit arithmetic for CHAOS_INTERVAL then, e.g., (60uL*RTIMER_SECOND) */
+#ifndef CHAOS_LONG_INTERVAL
+#define CHAOS_LONG_INTERVAL 0
+#endif /* CHAOS_LONG_INTERVAL */
+
 /* start a round every CHAOS_INTERVAL seconds
  * One needs to ensure that  CHAOS_ROUND_MAX_SLOTS * CHAOS_SLOT_LEN does not exceed CHAOS_INTERVAL minus some buffer for app, logging etc.
  * */
@@ -94,6 +319,17 @@
 #define CHAOS_USE_MSPGCC_RAND 0
 #endif /* CHAOS_USE_MSPGCC_RAND */
 
+/* fixed random seed for reproducible runs (e.g., Cooja benchmarks); nodes still differ by node id.
+ * 0: seed from the hardware */
+#ifndef CHAOS_RANDOM_SEED
+#define CHAOS_RANDOM_SEED 0
+#endif /* CHAOS_RANDOM_SEED */
+
+/* entries of the table behind chaos_random_generator_fast(): power of two, at most 256 */
+#ifndef CHAOS_RANDOM_TABLE_SIZE
+#define CHAOS_RANDOM_TABLE_SIZE 256
+#endif /* CHAOS_RANDOM_TABLE_SIZE */
+
 #ifndef CHAOS_MULTI_CHANNEL
 #define CHAOS_MULTI_CHANNEL 0
 #endif /* CHAOS_MULTI_CHANNEL */
@@ -102,10 +338,65 @@
 #define CHAOS_MULTI_CHANNEL_ADAPTIVE 0
 #endif /* CHAOS_MULTI_CHANNEL_ADAPTIVE */
 
+/* per-channel link statistics (rx outcomes, PRR, RSSI, hops) with multi-channel,
+ * reported every CHAOS_CHANNEL_STATS_PERIOD rounds, see chaos_multichannel_get_stats() */
+#ifndef CHAOS_CHANNEL_STATS
+#define CHAOS_CHANNEL_STATS 0
+#endif /* CHAOS_CHANNEL_STATS */
+
+#ifndef CHAOS_CHANNEL_STATS_PERIOD
+#define CHAOS_CHANNEL_STATS_PERIOD 32
+#endif /* CHAOS_CHANNEL_STATS_PERIOD */
+
+/* let the initiator regenerate the hopping sequence, weighted by the per-channel PRR
+ * collected from the network, instead of only skipping black-listed channels.
+ * Requires CHAOS_MULTI_CHANNEL_ADAPTIVE, CHAOS_PIGGYBACK and the hopping service in the app list */
+#ifndef CHAOS_HOPPING_REGENERATION
+#define CHAOS_HOPPING_REGENERATION 0
+#endif /* CHAOS_HOPPING_REGENERATION */
+
+/* rounds between two regenerations on the initiator */
+#ifndef CHAOS_HOPPING_REGENERATION_PERIOD
+#define CHAOS_HOPPING_REGENERATION_PERIOD 16
+#endif /* CHAOS_HOPPING_REGENERATION_PERIOD */
+
+/* every Nth slot (power of 2) keeps the default sequence, so that nodes with a stale
+ * weighted sequence still hear their neighbors and learn the new weights */
+#ifndef CHAOS_HOPPING_DEFAULT_SLOT_PERIOD
+#define CHAOS_HOPPING_DEFAULT_SLOT_PERIOD 4
+#endif /* CHAOS_HOPPING_DEFAULT_SLOT_PERIOD */
+
+#if CHAOS_HOPPING_DEFAULT_SLOT_PERIOD < 1 || (CHAOS_HOPPING_DEFAULT_SLOT_PERIOD & (CHAOS_HOPPING_DEFAULT_SLOT_PERIOD - 1))
+#error "CHAOS_HOPPING_DEFAULT_SLOT_PERIOD must be a power of 2"
+#endif
+
 #ifndef CHAOS_RF_CHANNEL
 #define CHAOS_RF_CHANNEL 26
 #endif /* CHAOS_RF_CHANNEL */
 
+/* split the channels into disjoint groups, so that independent networks
+ * (each with its own initiator, e.g., through leader election or a per-group INITIATOR_NODE)
+ * run their rounds at the same time without interfering.
+ * With CHAOS_MULTI_CHANNEL, group g hops over the channels with index g modulo CHAOS_CHANNEL_GROUPS;
+ * otherwise group g uses channel CHAOS_RF_CHANNEL - g */
+#ifndef CHAOS_CHANNEL_GROUPS
+#define CHAOS_CHANNEL_GROUPS 1
+#endif /* CHAOS_CHANNEL_GROUPS */
+
+/* channel group of a node at boot, see chaos_multichannel_set_group() to change it at runtime */
+#ifndef CHAOS_CHANNEL_GROUP_OF
+#define CHAOS_CHANNEL_GROUP_OF(ID) (0)
+#endif /* CHAOS_CHANNEL_GROUP_OF */
+
+/* bridge nodes move on to the next group every CHAOS_CHANNEL_GROUP_BRIDGE_ROUNDS rounds (0: never) */
+#ifndef CHAOS_CHANNEL_GROUP_IS_BRIDGE
+#define CHAOS_CHANNEL_GROUP_IS_BRIDGE(ID) (0)
+#endif /* CHAOS_CHANNEL_GROUP_IS_BRIDGE */
+
+#ifndef CHAOS_CHANNEL_GROUP_BRIDGE_ROUNDS
+#define CHAOS_CHANNEL_GROUP_BRIDGE_ROUNDS 0
+#endif /* CHAOS_CHANNEL_GROUP_BRIDGE_ROUNDS */
+
 #ifndef CHAOS_TX_POWER
 #if TESTBED == twist
 #define CHAOS_TX_POWER CC2420_TXPOWER_MAX
@@ -54,6 +54,10 @@
 #include "chaos-scheduler.h"
 #include "chaos-control.h"
 #include "chaos-config.h"
+#include "chaos-drift.h"
+#include "chaos-termination.h"
+#include "chaos-slot-calibration.h"
+#include "chaos-probe.h"
 //for NETSTACK_RADIO_sfd_sync
 #include "chaos-platform-specific.h"
 #include "leds.h"
@@ -91,7 +95,7 @@ static struct pt chaos_round_proc_pt;
 
 static volatile vht_clock_t round_rtimer = 0;
 static uint16_t round_number = 0;
-static volatile rtimer_clock_t current_round_begin = 0;
+static volatile chaos_interval_t current_round_begin = 0;
 static volatile clock_time_t last_round_clock_time = 0;
 
 /* used in RTIMER_DCO_SYNC() */
@@ -99,7 +103,25 @@ volatile rtimer_clock_t rtimer_ref = 0, dco_ref = 0;
 
 static volatile uint8_t failed_rounds = 0;
 
-rtimer_clock_t chaos_control_get_current_round_begin(){
+#if CHAOS_FAST_RESYNC
+#define CHAOS_FAILED_ROUNDS_LIMIT (CHAOS_FAILED_ROUNDS_RESYNC_THRESHOLD + CHAOS_FAST_RESYNC_ROUNDS)
+
+/* double the guard with every failed round to catch up with the
+ * accumulated drift while listening on the predicted schedule */
+rtimer_clock_t
+chaos_control_get_round_guard_time(void) {
+  uint32_t guard = chaos_drift_get_round_guard_time();
+  if( IS_INITIATOR() || failed_rounds == 0 ){
+    return guard;
+  }
+  guard <<= MIN(failed_rounds, 8);
+  return MIN(guard, CHAOS_FAST_RESYNC_MAX_GUARD);
+}
+#else
+#define CHAOS_FAILED_ROUNDS_LIMIT (CHAOS_FAILED_ROUNDS_RESYNC_THRESHOLD)
+#endif /* CHAOS_FAST_RESYNC */
+
+chaos_interval_t chaos_control_get_current_round_begin(){
   return current_round_begin;
 }
 
@@ -132,12 +154,42 @@ typedef struct{
     commit :2;                /* commit join */
 } commit_field_t;
 
+#if CHAOS_SLOT_TIMING_HISTOGRAM
+/* one line per app and timing phase with samples: bucket counts and the upper bound of the p99 bucket [us] */
 static void
-chaos_post_processing()
+print_slot_timing_histogram()
+{
+  int a, p, b;
+  for( a=0; a<CHAOS_SLOT_TIMING_HISTOGRAM_APPS; a++ ){
+    for( p=0; p<SLOTNUMBER; p++ ){
+      const uint16_t* hist = chaos_slot_timing_histogram[a][p];
+      uint32_t total = 0, sum = 0;
+      for( b=0; b<CHAOS_SLOT_TIMING_HISTOGRAM_BUCKETS; b++ ){
+        total += hist[b];
+      }
+      if( total == 0 ){
+        continue;
+      }
+      printf("{rd %u hist %u %u} ", round_number, a, p);
+      for( b=0; b<CHAOS_SLOT_TIMING_HISTOGRAM_BUCKETS; b++ ){
+        printf("%u ", hist[b]);
+      }
+      for( b=0; b<CHAOS_SLOT_TIMING_HISTOGRAM_BUCKETS - 1; b++ ){
+        sum += hist[b];
+        if( sum * 100 >= total * 99 ){
+          break;
+        }
+      }
+      printf("p99 %lu\n", DCO_TO_US(1UL << (CHAOS_SLOT_TIMING_HISTOGRAM_SHIFT + b)));
+    }
+  }
+}
+#endif /* CHAOS_SLOT_TIMING_HISTOGRAM */
+
+/* statistics of the last round */
+static void
+print_round_report()
 {
-  COOJA_DEBUG_LINE();
-  LEDS_ON(LEDS_RED);
-  chaos_log_process_pending();
   int i;
   printf("{rd %u stats} ", round_number);
   for( i=0; i<CHAOS_SLOT_STATS_SIZE; i++ ){
@@ -157,10 +209,58 @@ chaos_post_processing()
   }
   printf(" end\n");
 #endif
+#if CHAOS_SLOT_TIMING_HISTOGRAM
+  if( round_number % CHAOS_SLOT_TIMING_HISTOGRAM_ROUNDS == 0 ){
+    print_slot_timing_histogram();
+    memset(chaos_slot_timing_histogram, 0, sizeof(chaos_slot_timing_histogram));
+  }
+#endif /* CHAOS_SLOT_TIMING_HISTOGRAM */
   //duty cycle, per million
   uint32_t tx_permil = (chaos_slot_timing_tx_sum);
   uint32_t rx_permil = (chaos_slot_timing_rx_sum);
   uint32_t dc_permil =  (chaos_slot_timing_tx_sum + chaos_slot_timing_rx_sum);
+#if CHAOS_CHANNEL_STATS
+  if( round_number % CHAOS_CHANNEL_STATS_PERIOD == 0 ){
+    chaos_multichannel_print_stats(round_number);
+  }
+#endif /* CHAOS_CHANNEL_STATS */
+#if CHAOS_ADAPTIVE_TERMINATION
+  printf("{rd %u term} rx %u lacks %u\n", round_number, chaos_termination_get_rx_success(), chaos_termination_get_neighbor_lacks());
+#endif /* CHAOS_ADAPTIVE_TERMINATION */
+#if CHAOS_SLOT_OVERRUN_DETECTION
+  printf("{rd %u overruns} ", round_number);
+  for( i=0; i<chaos_app_count; i++ ){
+    printf("%u ", chaos_get_slot_overruns(i));
+  }
+  printf(" end\n");
+#endif /* CHAOS_SLOT_OVERRUN_DETECTION */
+#if CHAOS_ENERGY_ACCOUNTING
+  {
+    /* last round, then all rounds since boot per app: tx listen rx cpu [us] */
+    const chaos_energy_t* e = chaos_get_energy_round();
+    printf("{rd %u energy} %lu %lu %lu %lu |", round_number, DCO_TO_US(e->radio_tx), DCO_TO_US(e->radio_listen),
+        DCO_TO_US(e->radio_rx), DCO_TO_US(e->cpu));
+    for( i=0; i<chaos_app_count; i++ ){
+      e = chaos_get_energy_app(i);
+      printf(" %lu %lu %lu %lu |", e->radio_tx, e->radio_listen, e->radio_rx, e->cpu);
+    }
+    printf("\n");
+  }
+#endif /* CHAOS_ENERGY_ACCOUNTING */
+#if CHAOS_PROBES
+  chaos_probe_print(round_number);
+#endif /* CHAOS_PROBES */
+#if CHAOS_TIMELINE
+  {
+    /* app, slots, slot length [us]: lets the timeline tool place the slot logs */
+    const chaos_app_t* app = scheduler_get_current_app();
+    for( i=0; i<chaos_app_count && chaos_apps[i] != app; i++ );
+    if( i < chaos_app_count ){
+      printf("{rd %u tl} %s %u %lu\n", round_number, app->name, chaos_get_round_slots(),
+          (uint32_t)CHAOS_SLOT_LENGTH(i) * 1000000UL / RTIMER_SECOND);
+    }
+  }
+#endif /* CHAOS_TIMELINE */
   printf("{rd %u dc} interval %lu tx %lu + rx %lu = dc %lu [us]\n", round_number, RTIMER_TO_DCO_U32(CHAOS_INTERVAL), tx_permil, rx_permil, dc_permil);
 
 //  printf("{rd %u slots} ", round_number);
@@ -221,7 +321,58 @@ chaos_post_processing()
     }
   }
 #endif /* NETSTACK_CONF_WITH_CHAOS_NODE_DYNAMIC */
-  chaos_random_generator_update_table();
+}
+
+#if CHAOS_BUDGETED_PROCESSING
+static rtimer_clock_t budget_ref, budget_offset;
+static uint8_t budget_unbounded;
+static uint16_t reports_skipped = 0;
+
+/* between-round work must end before the pre-processing of the next round */
+static void
+budget_set(rtimer_clock_t ref, chaos_interval_t offset)
+{
+  chaos_interval_t reserve = (ROUND_PRE_PROCESSING_TIME * RTIMER_SECOND) / CLOCK_SECOND + CHAOS_BUDGETED_PROCESSING_GUARD;
+  offset = offset > reserve ? offset - reserve : 0;
+  /* beyond one rtimer period (CHAOS_LONG_INTERVAL) there is time for everything */
+  budget_unbounded = offset > 0xff00;
+  budget_ref = ref;
+  budget_offset = offset;
+}
+
+static uint8_t
+budget_left()
+{
+  return budget_unbounded || !chaos_schedule_check_timer_miss(budget_ref, budget_offset, RTIMER_NOW());
+}
+#endif /* CHAOS_BUDGETED_PROCESSING */
+
+/* Between-round work. ref + offset: wakeup for the next round (rtimer) */
+static void
+chaos_post_processing(rtimer_clock_t ref, chaos_interval_t offset)
+{
+  COOJA_DEBUG_LINE();
+  LEDS_ON(LEDS_RED);
+#if CHAOS_BUDGETED_PROCESSING
+  budget_set(ref, offset);
+  /* small jobs in order of need; what does not fit waits for the next gap */
+  while(budget_left() && !chaos_random_generator_update_table_step(CHAOS_BUDGETED_PROCESSING_RANDOM_STEP));
+  if(budget_left()) {
+    if(reports_skipped) {
+      printf("{rd %u pp} skipped %u reports\n", round_number, reports_skipped);
+      reports_skipped = 0;
+    }
+    print_round_report();
+  } else {
+    /* the report is about the last round only: drop it */
+    reports_skipped++;
+  }
+  while(budget_left() && chaos_log_process_pending_max(CHAOS_BUDGETED_PROCESSING_LOG_STEP));
+#else
+  chaos_log_process_pending();
+  print_round_report();
+  chaos_random_generator_update_table_step(CHAOS_RANDOM_TABLE_SIZE);
+#endif /* CHAOS_BUDGETED_PROCESSING */
   COOJA_DEBUG_LINE();
   LEDS_OFF(LEDS_RED);
 }
@@ -263,7 +414,7 @@ PT_THREAD(chaos_round_proc(struct rtimer *t, void *ptr))
     COOJA_DEBUG_LINE();
     scheduler_round_end();
   } else {
-    failed_rounds=CHAOS_FAILED_ROUNDS_RESYNC_THRESHOLD; //app is NULL!! Panic!
+    failed_rounds=CHAOS_FAILED_ROUNDS_LIMIT; //app is NULL!! Panic!
   }
 
   COOJA_DEBUG_LINE();
@@ -347,17 +498,54 @@ chaos_schedule_check_vht_timer_miss(vht_clock_t ref_time, vht_clock_t offset, vh
     return now_has_overflowed;
   }
 }
+#if CHAOS_LONG_INTERVAL
+/* Long intervals are slept in hops of at most CHAOS_LONG_INTERVAL_HOP rtimer ticks.
+ * Each hop is scheduled from the exact target of the previous one, so the drift
+ * corrected wakeup time is kept; the last hop is 1-2 hops long to stay clear of RTIMER_MIN_DELAY.
+ * Keep 2*CHAOS_LONG_INTERVAL_HOP below half the rtimer period for the 16-bit timer comparisons */
+#define CHAOS_LONG_INTERVAL_HOP 0x3000
+static rtimer_clock_t long_interval_target;
+static uint32_t long_interval_left;
+
+static void
+chaos_long_interval_hop(struct rtimer *t, void *ptr)
+{
+  if(long_interval_left > 2 * CHAOS_LONG_INTERVAL_HOP) {
+    long_interval_target += CHAOS_LONG_INTERVAL_HOP;
+    long_interval_left -= CHAOS_LONG_INTERVAL_HOP;
+    rtimer_set_override(t, long_interval_target, 1, chaos_long_interval_hop, NULL);
+  } else {
+    long_interval_target += long_interval_left;
+    long_interval_left = 0;
+    rtimer_set_override(t, long_interval_target, 1, (void (*)(struct rtimer *, void *))chaos_round_proc, NULL);
+  }
+}
+#endif /* CHAOS_LONG_INTERVAL */
+
 /* Schedule a wakeup at a specified offset from a reference time.
  * Provides basic protection against missed deadlines and timer overflows
  * A non-zero return value signals to chaos_schedule_round a missed deadline.
  * If conditional: schedule only if the deadline is not missed.
  * Otherwise: schedule regardless of deadline miss. */
 static uint8_t
-chaos_schedule_round(struct rtimer *tm, rtimer_clock_t ref_time, rtimer_clock_t offset, int conditional)
+chaos_schedule_round(struct rtimer *tm, rtimer_clock_t ref_time, chaos_interval_t offset, int conditional)
 {
   uint16_t now;
   uint8_t r = 0, missed = 0;
   now = RTIMER_NOW();
+#if CHAOS_LONG_INTERVAL
+  if(offset > 2 * CHAOS_LONG_INTERVAL_HOP) {
+    missed = chaos_schedule_check_timer_miss(ref_time, CHAOS_LONG_INTERVAL_HOP, now);
+    if(missed && conditional) {
+      PRINTF("Schedule: Missed\n");
+      return 0;
+    }
+    long_interval_target = ref_time + CHAOS_LONG_INTERVAL_HOP;
+    long_interval_left = offset - CHAOS_LONG_INTERVAL_HOP;
+    r = rtimer_set_override(tm, long_interval_target, 1, chaos_long_interval_hop, NULL);
+    return r == RTIMER_OK;
+  }
+#endif /* CHAOS_LONG_INTERVAL */
   missed = chaos_schedule_check_timer_miss(ref_time, offset, now);
 //  uint16_t goal = ref_time + offset;
 //  PRINTF("Schedule: %u + %u = %u @ %u\n", (uint16_t)ref_time, (uint16_t)offset, goal, now);
@@ -422,8 +610,13 @@ PROCESS_THREAD(chaos_process, ev, data)
   static rtimer_clock_t round_offset_to_radio_on = 0;
   /* rtimer ticks delay of rtimer wakeup from scheduled time */
   static rtimer_clock_t rtimer_delay = 0;
-  static rtimer_clock_t round_scheduled_offset;
+  static chaos_interval_t round_scheduled_offset;
   static uint8_t start_round_asap = 0;
+  /* drift correction of the current prediction and nominal time since the last synced round */
+  static int32_t drift_correction = 0, drift_correction_sum = 0;
+  static uint32_t drift_elapsed = 0;
+  /* round guard of the scheduled round, captured once as the drift and resync guards change with the round outcome */
+  static rtimer_clock_t round_guard_time = ROUND_GUARD_TIME;
   PROCESS_BEGIN();
 
   chaos_pre_processing(NULL);
@@ -442,6 +635,9 @@ PROCESS_THREAD(chaos_process, ev, data)
       scheduler_init();
       PROCESS_PT_SPAWN(&associate_pt, chaos_associate_proc(&associate_pt));
       chaos_log_process_pending();
+      chaos_drift_reset();
+      drift_correction_sum = 0;
+      drift_elapsed = 0;
       if( IS_INITIATOR() ){
         PRINTF("Chaos initiator starting with ID %u\n", node_id);
         rtimer_delay = RTIMER_LATENCY_INITIATOR;
@@ -463,15 +659,21 @@ PROCESS_THREAD(chaos_process, ev, data)
             (uint16_t)(VHT_TO_RTIMER(round_rtimer) + current_round_begin - round_offset_to_radio_on - rtimer_delay - ROUND_GUARD_TIME),
             (uint16_t)(VHT_TO_RTIMER(round_rtimer) + current_round_begin),
             RTIMER_NOW());
-        rtimer_clock_t round_rtimer_rt = VHT_TO_RTIMER(round_rtimer);
-        round_scheduled_offset = current_round_begin - round_offset_to_radio_on - ROUND_GUARD_TIME - rtimer_delay;
+        /* the initiator is the time source: never correct it */
+        drift_correction = IS_INITIATOR() ? 0 : chaos_drift_get_correction(current_round_begin);
+        rtimer_clock_t round_rtimer_rt = VHT_TO_RTIMER(round_rtimer + drift_correction);
+        round_guard_time = CHAOS_ROUND_GUARD_TIME;
+        round_scheduled_offset = current_round_begin - round_offset_to_radio_on - round_guard_time - rtimer_delay;
         success = chaos_schedule_round(&round_scheduler_timer, round_rtimer_rt, round_scheduled_offset, 1);
-        round_rtimer += RTIMER_TO_VHT(current_round_begin);
+        round_rtimer += RTIMER_TO_VHT(current_round_begin) + drift_correction;
+        drift_correction_sum += drift_correction;
+        drift_elapsed += current_round_begin;
         leds_blink();
-        chaos_post_processing();
+        chaos_post_processing(round_rtimer_rt, round_scheduled_offset);
         static timer_t round_rtimer_copy = {0, 0};
         round_rtimer_copy.ref = round_rtimer_rt;
-        round_rtimer_copy.offset = round_scheduled_offset - (ROUND_PRE_PROCESSING_TIME * RTIMER_SECOND) / CLOCK_SECOND;
+        /* the sniffer works within one rtimer period */
+        round_rtimer_copy.offset = MIN(round_scheduled_offset, 0x7fff) - (ROUND_PRE_PROCESSING_TIME * RTIMER_SECOND) / CLOCK_SECOND;
 #if NETSTACK_CONF_WITH_CHAOS_LEADER_ELECTION
         int poll_state = process_post(&chaos_sniff_leader_process, PROCESS_EVENT_POLL, (process_data_t)&round_rtimer_copy);
         if(poll_state != PROCESS_ERR_OK){
@@ -484,17 +686,30 @@ PROCESS_THREAD(chaos_process, ev, data)
           COOJA_DEBUG_LINE();
 #if ROUND_DELAY_COMPENSATION
 
-          rtimer_delay  = /* convert this */ VHT_TO_RTIMER(get_round_start() - round_rtimer) - (current_round_begin - ROUND_GUARD_TIME - round_offset_to_radio_on - rtimer_delay);
+          rtimer_delay  = /* convert this */ VHT_TO_RTIMER(get_round_start() - round_rtimer) - (current_round_begin - round_guard_time - round_offset_to_radio_on - rtimer_delay);
           /* add a guard */
           rtimer_delay += MAX(rtimer_delay >> 1, ROUND_OFFSET_TO_RADIO_ON);
 #endif /* ROUND_DELAY_COMPENSATION */
           if( get_round_synced() ){ //sync round_rtimer
             //printf("rr %lx %lx\n", round_rtimer, get_round_rtimer());
+            if( !IS_INITIATOR() ){
+              /* offset of the synced start w.r.t. the nominal (uncorrected) prediction */
+              chaos_drift_add_sample((int32_t)(get_round_rtimer() - round_rtimer) + drift_correction_sum, drift_elapsed);
+            }
+            drift_correction_sum = 0;
+            drift_elapsed = 0;
             round_rtimer = get_round_rtimer();
+          } else {
+            /* keep predicting across the missed round, but with the full guard */
+            chaos_drift_round_missed();
           }
-          clock_time_t pre_processing_time = ((round_scheduled_offset * CLOCK_SECOND) / RTIMER_SECOND);
-          if(!chaos_schedule_check_timer_miss(last_round_clock_time - ROUND_PRE_PROCESSING_TIME, pre_processing_time, clock_time())){
-            ctimer_set_absolute(&chaos_pre_processing_ctimer, last_round_clock_time - ROUND_PRE_PROCESSING_TIME, pre_processing_time, chaos_pre_processing, NULL);
+          /* divide first: the offset may span an hour of rtimer ticks */
+          clock_time_t pre_processing_time = (round_scheduled_offset / RTIMER_SECOND) * CLOCK_SECOND
+              + ((round_scheduled_offset % RTIMER_SECOND) * CLOCK_SECOND) / RTIMER_SECOND;
+          clock_time_t pre_processing_start = last_round_clock_time - ROUND_PRE_PROCESSING_TIME;
+          /* full clock_time_t comparison as in timer_expired(), the 16-bit miss check wraps after 512 s */
+          if((clock_time_t)(clock_time() - pre_processing_start) < pre_processing_time){
+            ctimer_set_absolute(&chaos_pre_processing_ctimer, pre_processing_start, pre_processing_time, chaos_pre_processing, NULL);
           }
           //clock_time_t now = clock_time();
           //start leader sniffing if no stable leader
@@ -508,6 +723,7 @@ PROCESS_THREAD(chaos_process, ev, data)
             //compute next round start in case we missed its start
             round_number++;
           }
+          chaos_drift_round_missed();
           PRINTF("{rd: %u} Skipping round ss %d rd %u!\n", round_number, success, rtimer_delay);
         }
 #if ROUND_DELAY_COMPENSATION
@@ -516,10 +732,14 @@ PROCESS_THREAD(chaos_process, ev, data)
         round_offset_to_radio_on += MAX(round_offset_to_radio_on >> 1, ROUND_OFFSET_TO_RADIO_ON);
 #endif /* ROUND_DELAY_COMPENSATION */
         failed_rounds = ( get_round_synced() && success ) ? 0 : failed_rounds + 1;
+        if( chaos_multichannel_group_round_end() ){
+          /* moved to another channel group: associate with the network running there */
+          failed_rounds = CHAOS_FAILED_ROUNDS_LIMIT;
+        }
         COOJA_DEBUG_LINE();
 #if CHAOS_SYSTEM_STRESS_TEST > 0
         if( round_number > CHAOS_SYSTEM_STRESS_TEST ) {
-          uint16_t backoff_time = chaos_random_generator_produce() % 2000;
+          uint16_t backoff_time = chaos_random_generator_stream(CHAOS_RANDOM_STREAM_BACKOFF) % 2000;
           uint16_t ref = RTIMER_NOW();
           uint16_t timeout = backoff_time * RTIMER_SECOND/1024;
           printf("{Restarting} %u ms\n", backoff_time);
@@ -528,7 +748,7 @@ PROCESS_THREAD(chaos_process, ev, data)
           watchdog_reboot();
         }
 #endif
-      } while( failed_rounds < CHAOS_FAILED_ROUNDS_RESYNC_THRESHOLD); //XXX what if the INITIATOR gets disconnected?
+      } while( failed_rounds < CHAOS_FAILED_ROUNDS_LIMIT); //XXX what if the INITIATOR gets disconnected?
       COOJA_DEBUG_LINE();
     }
 
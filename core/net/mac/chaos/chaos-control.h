@@ -53,6 +53,7 @@ typedef struct chaos_app{
   void (*round_begin)(const uint16_t round_count, const uint8_t id);
   void (*round_begin_sniffer)(chaos_header_t* header);
   void (*round_end_sniffer)(const chaos_header_t* header);
+  const struct chaos_piggyback* piggyback; /* see chaos-piggyback.h */
 } chaos_app_t;
 
 uint16_t chaos_get_round_number();
@@ -61,7 +62,7 @@ uint16_t chaos_get_round_number();
 void chaos_control_set_round_number(uint16_t rn);
 #endif
 
-rtimer_clock_t chaos_control_get_current_round_begin();
+chaos_interval_t chaos_control_get_current_round_begin();
 
 vht_clock_t chaos_control_get_round_rtimer();
 
@@ -73,12 +74,17 @@ extern const uint8_t chaos_app_count;
 
 extern const chaos_app_t* const chaos_apps[];
 
-#define CHAOS_APP(name, slot_length, max_slots, requires_node_index, is_pending, round_begin) const chaos_app_t name = {#name, slot_length, max_slots, requires_node_index, is_pending, round_begin, NULL, NULL}
+#define CHAOS_APP(name, slot_length, max_slots, requires_node_index, is_pending, round_begin) const chaos_app_t name = {#name, slot_length, max_slots, requires_node_index, is_pending, round_begin, NULL, NULL, NULL}
 
-#define CHAOS_SERVICE(name, slot_length, max_slots, requires_node_index, is_pending, round_begin, sniffer_begin, sniffer_end) const chaos_app_t name = {#name, slot_length, max_slots, requires_node_index, is_pending, round_begin, sniffer_begin, sniffer_end}
+#define CHAOS_SERVICE(name, slot_length, max_slots, requires_node_index, is_pending, round_begin, sniffer_begin, sniffer_end) const chaos_app_t name = {#name, slot_length, max_slots, requires_node_index, is_pending, round_begin, sniffer_begin, sniffer_end, NULL}
+
+/* an app that also rides along in the rounds of other apps when CHAOS_PIGGYBACK is enabled */
+#define CHAOS_PIGGYBACK_APP(name, slot_length, max_slots, requires_node_index, is_pending, round_begin, piggyback) const chaos_app_t name = {#name, slot_length, max_slots, requires_node_index, is_pending, round_begin, NULL, NULL, piggyback}
 
 //you can have CHAOS_APPS only once, just like autostart in Contiki
 #define CHAOS_APPS(...) const chaos_app_t* const chaos_apps[] = {__VA_ARGS__}; \
-		                    const uint8_t chaos_app_count = sizeof(chaos_apps)/sizeof(chaos_apps[0]);
+		                    const uint8_t chaos_app_count = sizeof(chaos_apps)/sizeof(chaos_apps[0]); \
+		                    /* fails to compile with more apps than the header encodes: raise CHAOS_MAX_APPS */ \
+		                    typedef char chaos_apps_exceed_chaos_max_apps[(sizeof(chaos_apps)/sizeof(chaos_apps[0]) <= CHAOS_MAX_APPS) ? 1 : -1]
 
 #endif /* CHAOS_CONTROL_H_ */
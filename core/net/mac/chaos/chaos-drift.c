@@ -0,0 +1,172 @@
+/*******************************************************************************
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017 Beshr Al Nahas and Olaf Landsiedel.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+/**
+ * \file
+ *         A2-Synchrotron cross-round clock drift estimator.
+ *         Fits a line through the last CHAOS_DRIFT_HISTORY round-start
+ *         observations (cumulative nominal time vs. cumulative offset)
+ *         to predict the next round start and to size the round guard.
+ * \author
+ *         Beshr Al Nahas <beshr@chalmers.se>
+ *         Olaf Landsiedel <olafl@chalmers.se>
+ *
+ */
+
+#include "contiki.h"
+#include "chaos.h"
+#include "chaos-drift.h"
+
+#if CHAOS_DRIFT_COMPENSATION
+
+typedef struct {
+  int32_t offset_vht;
+  uint32_t elapsed;
+} drift_sample_t;
+
+static drift_sample_t samples[CHAOS_DRIFT_HISTORY];
+static uint8_t sample_idx = 0, sample_count = 0;
+static uint8_t last_round_missed = 1;
+static int32_t slope = 0;
+static rtimer_clock_t guard_time = ROUND_GUARD_TIME;
+
+/* fit y = a + slope * x through the cumulative points, with (0,0) as first point */
+static void
+drift_update_estimate(void) {
+  int64_t sx = 0, sy = 0, sxx = 0, sxy = 0;
+  int64_t y = 0;
+  uint32_t x = 0, span = 0;
+  int64_t n = sample_count + 1, den;
+  uint8_t i, idx, x_shift = 0;
+  /* oldest sample first */
+  idx = (sample_idx + CHAOS_DRIFT_HISTORY - sample_count) % CHAOS_DRIFT_HISTORY;
+  for(i = 0; i < sample_count; i++) {
+    span += samples[(idx + i) % CHAOS_DRIFT_HISTORY].elapsed;
+  }
+  /* scale x down to 16 bits so that the sums stay in int64 with hour-long intervals */
+  while((span >> x_shift) > 0xffff) {
+    x_shift++;
+  }
+  span = 0;
+  for(i = 0; i < sample_count; i++) {
+    span += samples[idx].elapsed;
+    x = span >> x_shift;
+    y += samples[idx].offset_vht;
+    sx += x;
+    sy += y;
+    sxx += (int64_t)x * x;
+    sxy += (int64_t)x * y;
+    idx = (idx + 1) % CHAOS_DRIFT_HISTORY;
+  }
+  /* scaling den back to rtimer ticks keeps the slope precision */
+  den = (n * sxx - sx * sx) << x_shift;
+  slope = den ? (int32_t)(((n * sxy - sx * sy) * (1L << CHAOS_DRIFT_SLOPE_SHIFT)) / den) : 0;
+
+  /* residual: worst per-round error left after drift correction */
+  int32_t residual, max_residual = 0;
+  for(i = 0; i < sample_count; i++) {
+    residual = samples[i].offset_vht - chaos_drift_get_correction(samples[i].elapsed);
+    residual = ABS_VHT(residual);
+    max_residual = MAX(max_residual, residual);
+  }
+  /* guard the residual on both sides plus one tick for rtimer rounding */
+  guard_time = VHT_TO_RTIMER(2 * (uint32_t)max_residual) + 1 + CHAOS_DRIFT_GUARD_MIN;
+  guard_time = MIN(guard_time, ROUND_GUARD_TIME);
+}
+
+void
+chaos_drift_reset(void) {
+  sample_idx = 0;
+  sample_count = 0;
+  slope = 0;
+  last_round_missed = 1;
+  guard_time = ROUND_GUARD_TIME;
+}
+
+void
+chaos_drift_add_sample(int32_t offset_vht, uint32_t elapsed) {
+  /* an offset beyond what the clocks can drift in elapsed is a resync, not drift */
+  int64_t max_offset_vht = RTIMER_TO_VHT(ROUND_GUARD_TIME)
+      + ((int64_t)elapsed * CHAOS_DRIFT_MAX_PPM * RT_VHT_PHI) / 1000000;
+  if(elapsed == 0 || ABS_VHT(offset_vht) > max_offset_vht) {
+    chaos_drift_reset();
+    return;
+  }
+  samples[sample_idx].offset_vht = offset_vht;
+  samples[sample_idx].elapsed = elapsed;
+  sample_idx = (sample_idx + 1) % CHAOS_DRIFT_HISTORY;
+  sample_count = MIN(sample_count + 1, CHAOS_DRIFT_HISTORY);
+  last_round_missed = 0;
+  if(sample_count >= CHAOS_DRIFT_MIN_SAMPLES) {
+    drift_update_estimate();
+  }
+}
+
+void
+chaos_drift_round_missed(void) {
+  last_round_missed = 1;
+}
+
+uint8_t
+chaos_drift_is_locked(void) {
+  return sample_count >= CHAOS_DRIFT_MIN_SAMPLES;
+}
+
+int32_t
+chaos_drift_get_slope(void) {
+  return slope;
+}
+
+int32_t
+chaos_drift_get_correction(uint32_t interval) {
+  if(!chaos_drift_is_locked()) {
+    return 0;
+  }
+  return (int32_t)(((int64_t)slope * interval) >> CHAOS_DRIFT_SLOPE_SHIFT);
+}
+
+rtimer_clock_t
+chaos_drift_get_round_guard_time(void) {
+  return (chaos_drift_is_locked() && !last_round_missed) ? guard_time : ROUND_GUARD_TIME;
+}
+
+#else /* CHAOS_DRIFT_COMPENSATION */
+
+void chaos_drift_reset(void) {}
+void chaos_drift_add_sample(int32_t offset_vht, uint32_t elapsed) {}
+void chaos_drift_round_missed(void) {}
+uint8_t chaos_drift_is_locked(void) { return 0; }
+int32_t chaos_drift_get_slope(void) { return 0; }
+int32_t chaos_drift_get_correction(uint32_t interval) { return 0; }
+rtimer_clock_t chaos_drift_get_round_guard_time(void) { return ROUND_GUARD_TIME; }
+
+#endif /* CHAOS_DRIFT_COMPENSATION */
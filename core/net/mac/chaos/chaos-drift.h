@@ -0,0 +1,103 @@
+/*******************************************************************************
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017 Beshr Al Nahas and Olaf Landsiedel.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+/**
+ * \file
+ *         A2-Synchrotron cross-round clock drift estimator.
+ * \author
+ *         Beshr Al Nahas <beshr@chalmers.se>
+ *         Olaf Landsiedel <olafl@chalmers.se>
+ *
+ */
+
+#ifndef CHAOS_DRIFT_H_
+#define CHAOS_DRIFT_H_
+
+#include "contiki.h"
+#include "chaos-config.h"
+
+/* number of round-start samples used for the regression */
+#ifndef CHAOS_DRIFT_HISTORY
+#define CHAOS_DRIFT_HISTORY 8
+#endif /* CHAOS_DRIFT_HISTORY */
+
+/* samples needed before we trust the estimate */
+#ifndef CHAOS_DRIFT_MIN_SAMPLES
+#define CHAOS_DRIFT_MIN_SAMPLES 3
+#endif /* CHAOS_DRIFT_MIN_SAMPLES */
+
+/* lower bound of the round guard when the estimator is locked, in rtimer ticks */
+#ifndef CHAOS_DRIFT_GUARD_MIN
+#define CHAOS_DRIFT_GUARD_MIN (4)
+#endif /* CHAOS_DRIFT_GUARD_MIN */
+
+/* worst relative drift between two nodes, in ppm. Larger round-start offsets reset the estimate */
+#ifndef CHAOS_DRIFT_MAX_PPM
+#define CHAOS_DRIFT_MAX_PPM 100
+#endif /* CHAOS_DRIFT_MAX_PPM */
+
+/* fixed point precision of the slope (VHT ticks per rtimer tick) */
+#define CHAOS_DRIFT_SLOPE_SHIFT 8
+
+/* Reset the history, e.g., after (re)association */
+void chaos_drift_reset(void);
+/* Add a round-start observation:
+ * offset_vht: measured round start minus the nominal (uncorrected) prediction
+ * elapsed: nominal rtimer ticks since the last observation */
+void chaos_drift_add_sample(int32_t offset_vht, uint32_t elapsed);
+/* The round did not sync: widen the guard until the next observation */
+void chaos_drift_round_missed(void);
+/* Predicted offset of the next round start after interval rtimer ticks, in VHT ticks */
+int32_t chaos_drift_get_correction(uint32_t interval);
+/* Guard time before the predicted round start, in rtimer ticks */
+rtimer_clock_t chaos_drift_get_round_guard_time(void);
+/* Estimated drift in VHT ticks per rtimer tick << CHAOS_DRIFT_SLOPE_SHIFT */
+int32_t chaos_drift_get_slope(void);
+uint8_t chaos_drift_is_locked(void);
+
+#if CHAOS_DRIFT_COMPENSATION
+#define CHAOS_DRIFT_ROUND_GUARD_TIME (chaos_drift_get_round_guard_time())
+#else
+#define CHAOS_DRIFT_ROUND_GUARD_TIME (ROUND_GUARD_TIME)
+#endif /* CHAOS_DRIFT_COMPENSATION */
+
+#if CHAOS_FAST_RESYNC
+/* widened after failed rounds, see chaos-control.c.
+ * Only the round wakeup and the round-start listen use it,
+ * the later unsynced slots keep CHAOS_DRIFT_ROUND_GUARD_TIME */
+rtimer_clock_t chaos_control_get_round_guard_time(void);
+#define CHAOS_ROUND_GUARD_TIME (chaos_control_get_round_guard_time())
+#else
+#define CHAOS_ROUND_GUARD_TIME CHAOS_DRIFT_ROUND_GUARD_TIME
+#endif /* CHAOS_FAST_RESYNC */
+
+#endif /* CHAOS_DRIFT_H_ */
@@ -42,9 +42,14 @@
 #ifndef CHAOS_HEADER_H
 #define CHAOS_HEADER_H
 
+#include <stddef.h>
 #include "contiki.h"
 #include "chaos-config.h"
 
+#if CHAOS_HEADER_COMPRESSION && CHAOS_HW_SECURITY
+#error "CHAOS_HEADER_COMPRESSION does not support CHAOS_HW_SECURITY"
+#endif
+
 #if CHAOS_HW_SECURITY
 typedef union {
    uint32_t security_frame_counter;
@@ -59,6 +64,12 @@ typedef union {
 /**
  * \brief Data structure used to represent Chaos data. (20Bytes with security, src address and without rank)+ 2-6 bytes MIC + 2 CRC + 1 SFD + 4 preamble = 29Bytes *32us = 928us
  */
+#if CHAOS_LARGE_SCALE
+typedef uint16_t chaos_node_index_t;
+#else
+typedef uint8_t chaos_node_index_t;
+#endif /* CHAOS_LARGE_SCALE */
+
 typedef struct __attribute__((packed)) chaos_header {
   uint8_t length;
   uint8_t chaos_fcf_0; /* frame control field p[0] */
@@ -90,29 +101,131 @@ typedef struct __attribute__((packed)) chaos_header {
   //uint8_t config_view:6, leave:1;         //TODO: OL implement me
   uint8_t slot_number_msb:1,
           join:1,     //flags for dynamic app scheduling
-          id:3,               //id application, channel control, join control, ...
-          next_round_id:3;     //id of the next round
-  uint8_t chaos_node_count;
+          id:3,               //id application, channel control, join control, ... (use CHAOS_HEADER_GET/SET_APP_ID)
+          next_round_id:3;     //id of the next round (use CHAOS_HEADER_GET/SET_NEXT_ROUND_ID)
+  uint8_t chaos_node_count; /* use CHAOS_HEADER_GET/SET_NODE_COUNT */
+#if CHAOS_LARGE_SCALE
+  uint8_t slot_number_ext:6, /* slot number bits 9-14 */
+          chaos_node_count_msb:2; /* node count bits 8-9 */
+#endif /* CHAOS_LARGE_SCALE */
+#if CHAOS_MAX_APPS > 8
+  /* in every frame of such an image, so that all later fields keep fixed offsets */
+  uint8_t id_ext:4, /* app id bits 3-6 */
+          next_round_id_ext:4; /* next round app id bits 3-6 */
+#endif /* CHAOS_MAX_APPS > 8 */
 #if CHAOS_USE_SRC_RANK
   uint8_t src_rank; /* hop count */
 #endif
   //uint8_t src_time_rank; // when did we sync last?
+#if CHAOS_SLOT_CALIBRATION
+  uint8_t slot_busy_max; /* longest busy part of a slot in this round (rtimer ticks), max over all nodes */
+#endif /* CHAOS_SLOT_CALIBRATION */
+#if CHAOS_MULTI_CHANNEL_ADAPTIVE
+  unsigned int channels_black_list_collected;
+#endif /* CHAOS_MULTI_CHANNEL_ADAPTIVE */
+#if CHAOS_HEADER_COMPRESSION
+  uint8_t epoch; /* CHAOS_HEADER_EPOCH_COMPACT flag | round hash */
+#endif /* CHAOS_HEADER_COMPRESSION */
+  /* round-constant fields from here on: not on the air in compact frames */
   rtimer_clock_t next_round_start;  //start time of the next round as offset to the start of this round (in 32kHz ticks) -> change this to more coarse grained
+#if CHAOS_CO_INITIATORS
+  uint8_t schedule_from_initiator; /* next_round_* set by the initiator rather than the default of a co-initiator */
+#endif /* CHAOS_CO_INITIATORS */
+#if CHAOS_SLOT_CALIBRATION
+  uint16_t slot_length; /* slot length of this round in rtimer ticks, set by the initiator */
+#endif /* CHAOS_SLOT_CALIBRATION */
 #if CHAOS_MULTI_CHANNEL_ADAPTIVE
   unsigned int channels_black_list_committed;
-  unsigned int channels_black_list_collected;
 #endif /* CHAOS_MULTI_CHANNEL_ADAPTIVE */
+#if CHAOS_HOPPING_REGENERATION
+  uint8_t hopping_epoch; /* weighted hopping sequence of this round, set by the initiator. 0: default sequence */
+#endif /* CHAOS_HOPPING_REGENERATION */
   uint16_t initiator_id;
   uint8_t payload[];
 } chaos_header_t;
 
+/* round-constant part of the header, replaced by the epoch byte in compact frames */
+#define CHAOS_HEADER_ROUND_INFO_OFFSET (offsetof(chaos_header_t, next_round_start))
+#define CHAOS_HEADER_ROUND_INFO_LEN (offsetof(chaos_header_t, payload) - CHAOS_HEADER_ROUND_INFO_OFFSET)
+#define CHAOS_HEADER_EPOCH_COMPACT 0x80
+#define CHAOS_HEADER_EPOCH(INITIATOR, ROUND) \
+  ((uint8_t)((INITIATOR) ^ ((INITIATOR) >> 7) ^ (ROUND) ^ ((ROUND) >> 7)) & 0x7f)
+#if CHAOS_HEADER_COMPRESSION
+#define CHAOS_HEADER_IS_COMPACT(H) ((H)->epoch & CHAOS_HEADER_EPOCH_COMPACT)
+/* shortest header the radio may accept before the compact bit can be read */
+#define CHAOS_HEADER_MIN_LEN (sizeof(chaos_header_t) - CHAOS_HEADER_ROUND_INFO_LEN)
+#else
+#define CHAOS_HEADER_IS_COMPACT(H) (0)
+#define CHAOS_HEADER_MIN_LEN (sizeof(chaos_header_t))
+#endif /* CHAOS_HEADER_COMPRESSION */
+
+#if CHAOS_LONG_INTERVAL
+typedef uint32_t chaos_interval_t;
+/* next_round_start on the air: 4-bit exponent, 12-bit mantissa, up to 4095 << 15 rtimer ticks.
+ * The initiator schedules with the decoded value, so all nodes agree on the exact interval */
+static inline rtimer_clock_t
+chaos_interval_encode(chaos_interval_t interval)
+{
+  uint8_t exponent = 0;
+  while(interval > 0x0fff && exponent < 15) {
+    interval >>= 1;
+    exponent++;
+  }
+  return ((rtimer_clock_t)exponent << 12) | (interval > 0x0fff ? 0x0fff : interval);
+}
+#define CHAOS_INTERVAL_ENCODE(T) chaos_interval_encode(T)
+#define CHAOS_INTERVAL_DECODE(E) ((chaos_interval_t)((E) & 0x0fff) << ((E) >> 12))
+#else
+typedef rtimer_clock_t chaos_interval_t;
+#define CHAOS_INTERVAL_ENCODE(T) ((rtimer_clock_t)(T))
+#define CHAOS_INTERVAL_DECODE(E) ((chaos_interval_t)(E))
+#endif /* CHAOS_LONG_INTERVAL */
+
 typedef struct __attribute__((packed)) chaos_leader {
   vht_clock_t round_rtimer;
-  rtimer_clock_t next_round_start;
+  rtimer_clock_t next_round_start; /* as in the header, see CHAOS_INTERVAL_DECODE */
   uint16_t initiator_id;
   uint16_t round_number;
-  uint8_t chaos_node_count;
+  chaos_node_index_t chaos_node_count;
   uint8_t next_round_id;
 } chaos_leader_t;
 
+#if CHAOS_LARGE_SCALE
+#define CHAOS_HEADER_MAX_SLOTS (1u << 15)
+#define CHAOS_HEADER_MAX_NODES (1u << 10)
+#define CHAOS_HEADER_GET_SLOT_NUMBER(H) \
+  ((uint16_t)(H)->slot_number | ((uint16_t)(H)->slot_number_msb << 8) | ((uint16_t)(H)->slot_number_ext << 9))
+#define CHAOS_HEADER_SET_SLOT_NUMBER(H, S) \
+  do { (H)->slot_number = (S); (H)->slot_number_msb = ((S) >> 8) & 1; (H)->slot_number_ext = (S) >> 9; } while(0)
+#define CHAOS_HEADER_GET_NODE_COUNT(H) \
+  ((chaos_node_index_t)(H)->chaos_node_count | ((chaos_node_index_t)(H)->chaos_node_count_msb << 8))
+#define CHAOS_HEADER_SET_NODE_COUNT(H, N) \
+  do { (H)->chaos_node_count = (N); (H)->chaos_node_count_msb = (N) >> 8; } while(0)
+#else
+#define CHAOS_HEADER_MAX_SLOTS (1u << 9)
+#define CHAOS_HEADER_MAX_NODES (1u << 8)
+#define CHAOS_HEADER_GET_SLOT_NUMBER(H) \
+  ((uint16_t)(H)->slot_number | ((H)->slot_number_msb ? 0x100 : 0))
+#define CHAOS_HEADER_SET_SLOT_NUMBER(H, S) \
+  do { (H)->slot_number = (S); (H)->slot_number_msb = (S) > 255; } while(0)
+#define CHAOS_HEADER_GET_NODE_COUNT(H) ((H)->chaos_node_count)
+#define CHAOS_HEADER_SET_NODE_COUNT(H, N) do { (H)->chaos_node_count = (N); } while(0)
+#endif /* CHAOS_LARGE_SCALE */
+
+#if CHAOS_MAX_APPS > 128
+#error "CHAOS_MAX_APPS: the header encodes app ids up to 127"
+#elif CHAOS_MAX_APPS > 8
+#define CHAOS_HEADER_GET_APP_ID(H) ((uint8_t)((H)->id | ((H)->id_ext << 3)))
+#define CHAOS_HEADER_SET_APP_ID(H, A) \
+  do { (H)->id = (A); (H)->id_ext = (A) >> 3; } while(0)
+#define CHAOS_HEADER_GET_NEXT_ROUND_ID(H) ((uint8_t)((H)->next_round_id | ((H)->next_round_id_ext << 3)))
+#define CHAOS_HEADER_SET_NEXT_ROUND_ID(H, A) \
+  do { (H)->next_round_id = (A); (H)->next_round_id_ext = (A) >> 3; } while(0)
+#else
+#define CHAOS_HEADER_GET_APP_ID(H) ((H)->id)
+#define CHAOS_HEADER_SET_APP_ID(H, A) do { (H)->id = (A); } while(0)
+#define CHAOS_HEADER_GET_NEXT_ROUND_ID(H) ((H)->next_round_id)
+#define CHAOS_HEADER_SET_NEXT_ROUND_ID(H, A) do { (H)->next_round_id = (A); } while(0)
+#endif /* CHAOS_MAX_APPS */
+
 #endif /* CHAOS_HEADER_H */
@@ -44,6 +44,7 @@
 
 #include "contiki.h"
 #include <stdio.h>
+#include <string.h>
 #include "lib/ringbufindex.h"
 #include "net/mac/chaos/chaos.h"
 #include "net/mac/chaos/chaos-log.h"
@@ -64,10 +65,291 @@ static struct ringbufindex log_ringbuf;
 static chaos_log_t log_array[CHAOS_MAX_LOGS];
 static int log_dropped = 0;
 
+#if CHAOS_LOG_FLAGS
+#if CHAOS_LOG_FLAGS_DELTA
+#if (CHAOS_LOG_FLAGS_POOL_SIZE & (CHAOS_LOG_FLAGS_POOL_SIZE-1)) != 0
+#error CHAOS_LOG_FLAGS_POOL_SIZE must be power of two
+#endif
+#if LOG_APP_FLAGS_LEN > 255
+#error CHAOS_LOG_FLAGS_DELTA supports at most 255 flag bytes
+#endif
+/* Pool entries, in log order: a keyframe holds all flag bytes,
+ * a delta holds (index, value) pairs of the bytes that changed since the previous log.
+ * The slot interrupt only moves pool_put, the log processing only pool_get. */
+static uint8_t flags_pool[CHAOS_LOG_FLAGS_POOL_SIZE];
+static volatile uint16_t pool_put = 0, pool_get = 0;
+#define POOL_AT(I) (flags_pool[(I) & (CHAOS_LOG_FLAGS_POOL_SIZE - 1)])
+/* writer: flags of the last stored log */
+static uint8_t flags_last[LOG_APP_FLAGS_LEN];
+static uint16_t flags_last_round = 0;
+static uint8_t flags_since_keyframe = CHAOS_LOG_FLAGS_KEYFRAME;
+static uint8_t flags_need_keyframe = 1;
+/* reader: flags reconstructed up to the log being processed */
+static uint8_t flags_current[LOG_APP_FLAGS_LEN];
+static uint16_t flags_missing = 0;
+
+void
+chaos_log_set_flags(chaos_log_t *log, const uint8_t *flags, uint8_t len)
+{
+  uint8_t i, changed = 0;
+  uint16_t free_bytes = CHAOS_LOG_FLAGS_POOL_SIZE - (uint16_t)(pool_put - pool_get);
+  len = (flags != NULL) ? MIN(len, LOG_APP_FLAGS_LEN) : 0;
+  for(i = 0; i < LOG_APP_FLAGS_LEN; i++) {
+    changed += (i < len ? flags[i] : 0) != flags_last[i];
+  }
+  log->txrx.flags_missing = 0;
+  log->txrx.flags_offset = pool_put;
+  log->txrx.flags_keyframe = flags_need_keyframe || flags_since_keyframe >= CHAOS_LOG_FLAGS_KEYFRAME
+      || log->round_number != flags_last_round || 2 * changed >= LOG_APP_FLAGS_LEN;
+  log->txrx.flags_len = log->txrx.flags_keyframe ? LOG_APP_FLAGS_LEN : 2 * changed;
+  if(log->txrx.flags_len > free_bytes) {
+    /* no room: log the slot without flags, the next log is a keyframe again */
+    log->txrx.flags_missing = 1;
+    log->txrx.flags_len = 0;
+    flags_need_keyframe = 1;
+    return;
+  }
+  for(i = 0; i < LOG_APP_FLAGS_LEN; i++) {
+    uint8_t value = i < len ? flags[i] : 0;
+    if(log->txrx.flags_keyframe) {
+      POOL_AT(pool_put++) = value;
+    } else if(value != flags_last[i]) {
+      POOL_AT(pool_put++) = i;
+      POOL_AT(pool_put++) = value;
+    }
+    flags_last[i] = value;
+  }
+  flags_since_keyframe = log->txrx.flags_keyframe ? 1 : flags_since_keyframe + 1;
+  flags_need_keyframe = 0;
+  flags_last_round = log->round_number;
+}
+
+/* Flags of the next log in order, NULL if they were not stored; releases its pool bytes */
+static const uint8_t *
+log_get_flags(const chaos_log_t *log)
+{
+  uint16_t i = log->txrx.flags_offset;
+  uint16_t end = i + log->txrx.flags_len;
+  if(log->txrx.flags_missing) {
+    flags_missing++;
+    return NULL;
+  }
+  if(log->txrx.flags_keyframe) {
+    uint8_t j;
+    for(j = 0; j < LOG_APP_FLAGS_LEN; j++) {
+      flags_current[j] = POOL_AT(i++);
+    }
+  } else {
+    while(i != end) {
+      uint8_t index = POOL_AT(i++);
+      flags_current[index] = POOL_AT(i++);
+    }
+  }
+  pool_get = end;
+  return flags_current;
+}
+#else
+void
+chaos_log_set_flags(chaos_log_t *log, const uint8_t *flags, uint8_t len)
+{
+  if(flags == NULL || len == 0) {
+    memset(log->txrx.app_flags, 0, LOG_APP_FLAGS_LEN);
+  } else {
+    memcpy(log->txrx.app_flags, flags, MIN(len, LOG_APP_FLAGS_LEN));
+  }
+}
+
+static const uint8_t *
+log_get_flags(const chaos_log_t *log)
+{
+  return log->txrx.app_flags;
+}
+#endif /* CHAOS_LOG_FLAGS_DELTA */
+#else
+void
+chaos_log_set_flags(chaos_log_t *log, const uint8_t *flags, uint8_t len)
+{
+}
+#endif /* CHAOS_LOG_FLAGS */
+
+#if CHAOS_LOG_BINARY
+/* Binary log format, keep in sync with tools/chaos/chaos-log-decode.c
+ * A frame is SLIP framed (END 0xc0, ESC 0xdb) and holds:
+ *   version, field mask (CHAOS_LOG_BINARY_F_*), [flags length (varint)], records...
+ * A record holds:
+ *   state << 4 | rx status, round delta (zigzag), slot delta (zigzag, from 0 in a new round),
+ *   channel, go delta and sfd delta (DCO ticks, magnitude << 1 | sign),
+ *   [3 black lists (varint)], [join byte], [changed flag bytes: count, (index gap, value)...], [src id (varint)]
+ * Round, slot and flags are coded against the previous record, across the frames of a round.
+ * A frame with CHAOS_LOG_BINARY_F_RESET (new round, or logs dropped) codes its first record against all zeros.
+ * A count of flags length + 1 marks flags that were not stored (printed as ??), it leaves the reference as is. */
+#define CHAOS_LOG_BINARY_VERSION 2
+#define CHAOS_LOG_BINARY_F_BLACK_LIST 0x01
+#define CHAOS_LOG_BINARY_F_JOIN 0x02
+#define CHAOS_LOG_BINARY_F_FLAGS 0x04
+#define CHAOS_LOG_BINARY_F_SRC_ID 0x08
+#define CHAOS_LOG_BINARY_F_RESET 0x80
+#define CHAOS_LOG_BINARY_FLAGS_MISSING (LOG_APP_FLAGS_LEN + 1)
+#define SLIP_END 0xc0
+#define SLIP_ESC 0xdb
+#define SLIP_ESC_END 0xdc
+#define SLIP_ESC_ESC 0xdd
+
+#if CHAOS_DEBUG_PRINTF
+#define LOG_PUTCHAR(C) putchar(C)
+#else
+#define LOG_PUTCHAR(C)
+#endif
+
+static void
+log_put_byte(uint8_t b)
+{
+  if(b == SLIP_END) {
+    LOG_PUTCHAR(SLIP_ESC);
+    LOG_PUTCHAR(SLIP_ESC_END);
+  } else if(b == SLIP_ESC) {
+    LOG_PUTCHAR(SLIP_ESC);
+    LOG_PUTCHAR(SLIP_ESC_ESC);
+  } else {
+    LOG_PUTCHAR(b);
+  }
+}
+
+static void
+log_put_varint(uint32_t v)
+{
+  while(v >= 0x80) {
+    log_put_byte((uint8_t)v | 0x80);
+    v >>= 7;
+  }
+  log_put_byte((uint8_t)v);
+}
+
+static void
+log_put_zigzag(int32_t v)
+{
+  log_put_varint(((uint32_t)v << 1) ^ (uint32_t)(v >> 31));
+}
+
+/* DCO ticks as printed in the text log, which keeps the sign of "-0" */
+static void
+log_put_vht_delta(vht_clock_t t)
+{
+  if((long)t < 0) {
+    log_put_varint(((-(unsigned long)t) / DCO_VHT_PHI) << 1 | 1);
+  } else {
+    log_put_varint((t / DCO_VHT_PHI) << 1);
+  }
+}
+
+static struct {
+  uint16_t round_number;
+  uint16_t slot_number;
+#if CHAOS_LOG_FLAGS
+  uint8_t app_flags[LOG_APP_FLAGS_LEN];
+#endif /* CHAOS_LOG_FLAGS */
+} log_binary_last;
+static uint8_t log_binary_reset = 1;
+
+static void
+log_binary_frame_begin(const chaos_log_t *first)
+{
+  uint8_t fields = 0;
+#if CHAOS_MULTI_CHANNEL && CHAOS_MULTI_CHANNEL_ADAPTIVE
+  fields |= CHAOS_LOG_BINARY_F_BLACK_LIST;
+#endif /* CHAOS_MULTI_CHANNEL && CHAOS_MULTI_CHANNEL_ADAPTIVE */
+#if NETSTACK_CONF_WITH_CHAOS_NODE_DYNAMIC
+  fields |= CHAOS_LOG_BINARY_F_JOIN;
+#endif
+#if CHAOS_LOG_FLAGS
+  fields |= CHAOS_LOG_BINARY_F_FLAGS;
+#endif /* CHAOS_LOG_FLAGS */
+#if CHAOS_USE_SRC_ID
+  fields |= CHAOS_LOG_BINARY_F_SRC_ID;
+#endif
+  /* the budgeted processing prints a round in many small frames: keep the deltas running */
+  if(log_binary_reset || first->round_number != log_binary_last.round_number) {
+    fields |= CHAOS_LOG_BINARY_F_RESET;
+    log_binary_last.round_number = 0;
+    log_binary_last.slot_number = 0;
+#if CHAOS_LOG_FLAGS
+    memset(log_binary_last.app_flags, 0, sizeof(log_binary_last.app_flags));
+#endif /* CHAOS_LOG_FLAGS */
+    log_binary_reset = 0;
+  }
+  LOG_PUTCHAR(SLIP_END);
+  log_put_byte(CHAOS_LOG_BINARY_VERSION);
+  log_put_byte(fields);
+#if CHAOS_LOG_FLAGS
+  log_put_varint(LOG_APP_FLAGS_LEN);
+#endif /* CHAOS_LOG_FLAGS */
+}
+
+static void
+log_binary_frame_end(void)
+{
+  LOG_PUTCHAR(SLIP_END);
+}
+
+static void
+log_binary_txrx(const chaos_log_t *log, const uint8_t *app_flags)
+{
+  log_put_byte(log->txrx.state << 4 | log->txrx.rx_status);
+  log_put_zigzag((int32_t)log->round_number - log_binary_last.round_number);
+  if(log->round_number != log_binary_last.round_number) {
+    log_binary_last.slot_number = 0;
+  }
+  log_put_zigzag((int32_t)log->slot_number - log_binary_last.slot_number);
+  log_binary_last.round_number = log->round_number;
+  log_binary_last.slot_number = log->slot_number;
+  log_put_byte(log->channel);
+  log_put_vht_delta(log->txrx.t_go_delta);
+  log_put_vht_delta(log->txrx.t_sfd_delta);
+#if CHAOS_MULTI_CHANNEL && CHAOS_MULTI_CHANNEL_ADAPTIVE
+  log_put_varint(log->txrx.channel_black_list_local);
+  log_put_varint(log->txrx.channel_black_list_merged);
+  log_put_varint(log->txrx.channel_black_list_committed);
+#endif /* CHAOS_MULTI_CHANNEL && CHAOS_MULTI_CHANNEL_ADAPTIVE */
+#if NETSTACK_CONF_WITH_CHAOS_NODE_DYNAMIC
+  log_put_byte(log->txrx.join_slot_count << 2 | (log->txrx.join_committed != 0) << 1 | log->txrx.join_has_node_index);
+#endif
+#if CHAOS_LOG_FLAGS
+  if(app_flags == NULL) {
+    /* not stored: tell the decoder, the next record is coded against the previous one again */
+    log_put_varint(CHAOS_LOG_BINARY_FLAGS_MISSING);
+  } else {
+    uint16_t i, changed = 0, last_index = 0;
+    for(i = 0; i < LOG_APP_FLAGS_LEN; i++) {
+      changed += app_flags[i] != log_binary_last.app_flags[i];
+    }
+    log_put_varint(changed);
+    for(i = 0; i < LOG_APP_FLAGS_LEN; i++) {
+      if(app_flags[i] != log_binary_last.app_flags[i]) {
+        log_put_varint(i - last_index);
+        log_put_byte(app_flags[i]);
+        last_index = i;
+        log_binary_last.app_flags[i] = app_flags[i];
+      }
+    }
+  }
+#endif /* CHAOS_LOG_FLAGS */
+#if CHAOS_USE_SRC_ID
+  log_put_varint(log->txrx.src_node_id);
+#endif
+}
+#endif /* CHAOS_LOG_BINARY */
+
 
 /* Process pending log messages */
 void
 chaos_log_process_pending()
+{
+  chaos_log_process_pending_max(0xffff);
+}
+
+/* Process at most max_logs pending log messages, returns 1 if more are pending */
+uint8_t
+chaos_log_process_pending_max(uint16_t max_logs)
 {
   static int last_log_dropped = 0;
   int16_t log_index;
@@ -76,11 +358,42 @@ chaos_log_process_pending()
   if(log_dropped != last_log_dropped) {
     LOG("CHAOS:! logs dropped %u\n", log_dropped);
     last_log_dropped = log_dropped;
+#if CHAOS_LOG_BINARY
+    log_binary_reset = 1;
+#endif /* CHAOS_LOG_BINARY */
   }
+#if CHAOS_LOG_FLAGS && CHAOS_LOG_FLAGS_DELTA
+  static uint16_t last_flags_missing = 0;
+  if(flags_missing != last_flags_missing) {
+    LOG("CHAOS:! log flags dropped %u\n", flags_missing);
+    last_flags_missing = flags_missing;
+  }
+#endif /* CHAOS_LOG_FLAGS && CHAOS_LOG_FLAGS_DELTA */
+#if CHAOS_LOG_BINARY
+  if((log_index = ringbufindex_peek_get(&log_ringbuf)) == -1) {
+    return 0;
+  }
+  log_binary_frame_begin(&log_array[log_index]);
+#endif /* CHAOS_LOG_BINARY */
   while((log_index = ringbufindex_peek_get(&log_ringbuf)) != -1) {
+    if(max_logs-- == 0) {
+#if CHAOS_LOG_BINARY
+      log_binary_frame_end();
+#endif /* CHAOS_LOG_BINARY */
+      return 1;
+    }
     chaos_log_t *log = &log_array[log_index];
+#if CHAOS_LOG_FLAGS
+    const uint8_t *app_flags = (log->logtype == chaos_log_txrx) ? log_get_flags(log) : NULL;
+#else
+    const uint8_t *app_flags = NULL;
+#endif /* CHAOS_LOG_FLAGS */
     switch(log->logtype) {
       case chaos_log_txrx:
+#if CHAOS_LOG_BINARY
+        log_binary_txrx(log, app_flags);
+        break;
+#endif /* CHAOS_LOG_BINARY */
         LOG("{rd-%u st-%u ch-%u} ",
             log->round_number, log->slot_number, log->channel);
         LOG(CHAOS_STATE_TO_STRING(log->txrx.state));
@@ -113,7 +426,11 @@ chaos_log_process_pending()
         LOG("ap ");
         uint8_t i;
         for(i = 0; i < LOG_APP_FLAGS_LEN; i++) {
-          LOG("%02x", log->txrx.app_flags[i]);
+          if(app_flags != NULL) {
+            LOG("%02x", app_flags[i]);
+          } else {
+            LOG("??");
+          }
         }
 #endif /* CHAOS_LOG_FLAGS */
 #if CHAOS_USE_SRC_ID
@@ -130,6 +447,10 @@ chaos_log_process_pending()
     /* Remove input from ringbuf */
     ringbufindex_get(&log_ringbuf);
   }
+#if CHAOS_LOG_BINARY
+  log_binary_frame_end();
+#endif /* CHAOS_LOG_BINARY */
+  return 0;
 }
 
 /* Prepare addition of a new log.
@@ -99,7 +99,13 @@ typedef struct chaos_log_struct_t {
       uint8_t join_committed:1, join_has_node_index: 1, join_slot_count:6;
 #endif
 #if CHAOS_LOG_FLAGS
+#if CHAOS_LOG_FLAGS_DELTA
+      uint16_t flags_offset; /* start in the flag pool */
+      uint8_t flags_len; /* bytes in the flag pool */
+      uint8_t flags_keyframe:1, flags_missing:1;
+#else
       uint8_t app_flags[LOG_APP_FLAGS_LEN];
+#endif /* CHAOS_LOG_FLAGS_DELTA */
 #endif /* CHAOS_LOG_FLAGS */
       uint8_t state:4, rx_status:4;
     } txrx;
@@ -115,8 +121,12 @@ chaos_log_t *chaos_log_prepare_add();
 void chaos_log_commit();
 /* Initialize log module */
 void chaos_log_init();
+/* Set the flags of a prepared log, NULL or len 0 for none */
+void chaos_log_set_flags(chaos_log_t *log, const uint8_t *flags, uint8_t len);
 /* Process pending log messages */
 void chaos_log_process_pending();
+/* Process at most max_logs pending log messages, returns 1 if more are pending */
+uint8_t chaos_log_process_pending_max(uint16_t max_logs);
 
 #define CHAOS_LOG_ADD(log_type, init_code) do { \
     chaos_log_t *log = chaos_log_prepare_add(); \
@@ -146,7 +156,9 @@ void chaos_log_process_pending();
 #else /* WITH_CHAOS_LOG */
 
 #define chaos_log_init()
+#define chaos_log_set_flags(log, flags, len)
 #define chaos_log_process_pending()
+#define chaos_log_process_pending_max(max_logs) (0)
 #define CHAOS_LOG_ADD(log_type, init_code)
 #define CHAOS_LOG_ADD_MSG(...)
 #endif /* WITH_CHAOS_LOG */
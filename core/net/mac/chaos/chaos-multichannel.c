@@ -44,6 +44,7 @@
 #include "net/mac/chaos/chaos-header.h"
 #include "net/mac/chaos/chaos-multichannel.h"
 #include "net/mac/chaos/chaos-random-generator.h"
+#include "net/mac/chaos/chaos-probe.h"
 
 #if CHAOS_MULTI_CHANNEL
 #if CHAOS_MULTI_CHANNEL_ADAPTIVE
@@ -55,8 +56,42 @@ static uint16_t channel_prr[CHAOS_NUMBER_OF_CHANNELS];
 uint8_t chaos_channel_hopping_sequence[] = CHAOS_HOPPING_SEQUENCE;
 volatile uint16_t chaos_current_channel = 0;
 #endif /* CHAOS_MULTI_CHANNEL */
+#if CHAOS_MULTI_CHANNEL && CHAOS_CHANNEL_STATS
+static chaos_channel_stats_t channel_stats[CHAOS_NUMBER_OF_CHANNELS];
+/* moving averages in 8.8 fixed point (as channel_prr keeps its precision), the stats report the rounded upper byte.
+ * An 8-bit state with >> 3 would get stuck 7 below a constant input */
+static uint16_t stats_prr_avg[CHAOS_NUMBER_OF_CHANNELS];
+static int16_t stats_rssi_avg[CHAOS_NUMBER_OF_CHANNELS];
+#define STATS_EWMA(AVG, SAMPLE) ((AVG) += (((int32_t)(SAMPLE) << 8) - (int32_t)(AVG)) >> 3)
+#define STATS_EWMA_REPORT(AVG) (((AVG) + 0x80) >> 8)
+#endif /* CHAOS_MULTI_CHANNEL && CHAOS_CHANNEL_STATS */
+#if CHAOS_HOPPING_REGENERATION
+#if !CHAOS_MULTI_CHANNEL || !CHAOS_MULTI_CHANNEL_ADAPTIVE
+#error "CHAOS_HOPPING_REGENERATION needs CHAOS_MULTI_CHANNEL_ADAPTIVE"
+#endif
+static uint8_t weighted_hopping_sequence[CHAOS_HOPPING_SEQUENCE_SIZE];
+/* epoch of the weighted sequence we have, and of the sequence the initiator uses in this round.
+ * 0: default sequence */
+static uint8_t weighted_hopping_sequence_epoch = 0, round_hopping_epoch = 0;
+#define WEIGHTED_SEQUENCE_IN_SLOT(SLOT) \
+  (weighted_hopping_sequence_epoch != 0 && round_hopping_epoch == weighted_hopping_sequence_epoch \
+      && ((SLOT) & (CHAOS_HOPPING_DEFAULT_SLOT_PERIOD - 1)) != 0)
+#endif /* CHAOS_HOPPING_REGENERATION */
+#if CHAOS_CHANNEL_GROUPS > 1
+#define CHANNEL_GROUP_UNSET 0xff
+static uint8_t channel_group = CHANNEL_GROUP_UNSET, channel_group_next = CHANNEL_GROUP_UNSET;
+static uint16_t channel_group_rounds = 0;
+#endif /* CHAOS_CHANNEL_GROUPS > 1 */
 
 void chaos_multichannel_init(void) {
+#if CHAOS_CHANNEL_GROUPS > 1
+  /* (re)association: join the requested group */
+  if(channel_group_next == CHANNEL_GROUP_UNSET) {
+    channel_group_next = CHAOS_CHANNEL_GROUP_OF(node_id) % CHAOS_CHANNEL_GROUPS;
+  }
+  channel_group = channel_group_next;
+  channel_group_rounds = 0;
+#endif /* CHAOS_CHANNEL_GROUPS > 1 */
 #if CHAOS_MULTI_CHANNEL
   chaos_current_channel = chaos_multichannel_lookup_channel(0, 0);
 #if CHAOS_MULTI_CHANNEL_ADAPTIVE
@@ -74,6 +109,29 @@ void chaos_multichannel_init(void) {
 
 ALWAYS_INLINE void
 chaos_multichannel_update_black_list(uint8_t is_initiator, uint8_t round_synced, int rx_state, uint8_t app_id, chaos_header_t* const rx_header, chaos_header_t* const tx_header) {
+#if CHAOS_MULTI_CHANNEL && CHAOS_CHANNEL_STATS
+  if(round_synced || rx_state == CHAOS_TXRX_OK) {
+    uint8_t stats_idx = CHANNEL_IDX(chaos_current_channel);
+    chaos_channel_stats_t* stats = &channel_stats[stats_idx];
+    if(rx_state == CHAOS_TXRX_OK) {
+      stats->rx_ok++;
+      STATS_EWMA(stats_rssi_avg[stats_idx], (int8_t)CHAOS_RSSI_FIELD((uint8_t*)rx_header) + RSSI_CORRECTION_CONSTANT);
+      stats->rssi = STATS_EWMA_REPORT(stats_rssi_avg[stats_idx]);
+    } else if(rx_state == CHAOS_RX_NO_SFD) {
+      stats->rx_no_sfd++;
+    } else if(rx_state == CHAOS_RX_HEADER_ERROR) {
+      stats->rx_header_error++;
+    } else if(rx_state == CHAOS_RX_CRC_ERROR) {
+      stats->rx_crc_error++;
+    } else if(rx_state >= CHAOS_RX_TIMEOUT) {
+      stats->rx_timeout++;
+    } else {
+      stats->rx_other++;
+    }
+    STATS_EWMA(stats_prr_avg[stats_idx], rx_state == CHAOS_TXRX_OK ? 255 : 0);
+    stats->prr = STATS_EWMA_REPORT(stats_prr_avg[stats_idx]);
+  }
+#endif /* CHAOS_MULTI_CHANNEL && CHAOS_CHANNEL_STATS */
 #if CHAOS_MULTI_CHANNEL && CHAOS_MULTI_CHANNEL_ADAPTIVE
   uint8_t channel = chaos_multichannel_get_current_channel();
   uint8_t channel_idx = CHANNEL_IDX(channel);
@@ -86,10 +144,14 @@ chaos_multichannel_update_black_list(uint8_t is_initiator, uint8_t round_synced,
       uint8_t block_channel = channel_prr[channel_idx] < CHAOS_CHANNEL_PRR_THRESHOLD;
       channel_black_list_local = block_channel ? channel_black_list_local | (1U << (unsigned int)channel_idx) : channel_black_list_local & ~(1U << (unsigned int)channel_idx);
     }
-    if(app_id == rx_header->id) {
+    if(app_id == CHAOS_HEADER_GET_APP_ID(rx_header)) {
       if(success) { /* read flags from rx_header only if it is a sane packet */
         if(!is_initiator) {
           channel_black_list_committed = rx_header->channels_black_list_committed;
+#if CHAOS_HOPPING_REGENERATION
+          /* a stale sequence falls back to the default one for the rest of the round */
+          round_hopping_epoch = rx_header->hopping_epoch;
+#endif /* CHAOS_HOPPING_REGENERATION */
         }
         /* merge learned blacklist */
         channel_black_list_collected |= rx_header->channels_black_list_collected;
@@ -97,6 +159,9 @@ chaos_multichannel_update_black_list(uint8_t is_initiator, uint8_t round_synced,
       /* merge local blacklist and fill tx_header */
       tx_header->channels_black_list_collected = channel_black_list_collected | channel_black_list_local;
       tx_header->channels_black_list_committed = channel_black_list_committed;
+#if CHAOS_HOPPING_REGENERATION
+      tx_header->hopping_epoch = round_hopping_epoch;
+#endif /* CHAOS_HOPPING_REGENERATION */
     }
     //COOJA_DEBUG_PRINTF("update_black_list ch-%u St-1 %u St %u yt %u b %u bl %x", channel, old_prr, channel_prr[channel_idx], success, block_channel, channel_black_list_local);
   }
@@ -131,6 +196,11 @@ chaos_multichannel_round_init(uint8_t is_initiator, chaos_header_t* const tx_hea
   /* reset merged flags, but keep local flags */
   channel_black_list_collected = 0;
 #endif /* CHAOS_MULTI_CHANNEL && CHAOS_MULTI_CHANNEL_ADAPTIVE */
+#if CHAOS_HOPPING_REGENERATION
+  /* until the first frame tells otherwise, assume that our sequence is the current one */
+  round_hopping_epoch = weighted_hopping_sequence_epoch;
+  tx_header->hopping_epoch = round_hopping_epoch;
+#endif /* CHAOS_HOPPING_REGENERATION */
 }
 
 ALWAYS_INLINE unsigned int
@@ -166,14 +236,24 @@ ALWAYS_INLINE uint16_t
   uint8_t channel_sequence_offset = 0;
 #if CHAOS_MULTI_CHANNEL_PARALLEL_SEQUENCES
   if(slot_number > 0) { /* don't mess first slot for quicker association */
-    channel_sequence_offset = chaos_random_generator_fast() % CHAOS_MULTI_CHANNEL_PARALLEL_SEQUENCES;
+    channel_sequence_offset = chaos_random_generator_stream(CHAOS_RANDOM_STREAM_CHANNEL) % CHAOS_MULTI_CHANNEL_PARALLEL_SEQUENCES;
   }
 #endif /* CHAOS_MULTI_CHANNEL_PARALLEL_SEQUENCES */
-  return chaos_channel_hopping_sequence[((round_number<<CHAOS_HOPPING_ROUND_SHIFT) + slot_number + channel_sequence_offset) & (CHAOS_HOPPING_SEQUENCE_SIZE-1)];
+  const uint8_t* sequence = chaos_channel_hopping_sequence;
+#if CHAOS_HOPPING_REGENERATION
+  if(WEIGHTED_SEQUENCE_IN_SLOT(slot_number)) {
+    sequence = weighted_hopping_sequence;
+  }
+#endif /* CHAOS_HOPPING_REGENERATION */
+  uint16_t channel = sequence[((round_number<<CHAOS_HOPPING_ROUND_SHIFT) + slot_number + channel_sequence_offset) & (CHAOS_HOPPING_SEQUENCE_SIZE-1)];
+#if CHAOS_CHANNEL_GROUPS > 1
+  channel = CHAOS_CHANNEL_OF_GROUP(channel, chaos_multichannel_get_group());
+#endif /* CHAOS_CHANNEL_GROUPS > 1 */
+  return channel;
 // channel: x % 16 + 11
 //return ((round_number + slot_number) & (CHAOS_HOPPING_SEQUENCE_SIZE-1)) + RF_FIRST_CHANNEL;
 #else
-  return CHAOS_RF_CHANNEL;
+  return CHAOS_RF_CHANNEL - chaos_multichannel_get_group();
 #endif /* CHAOS_MULTI_CHANNEL */
 }
 
@@ -184,6 +264,10 @@ ALWAYS_INLINE uint16_t
   uint8_t mask = 1U<<(CHANNEL_IDX(next_channel));
   uint8_t blocked = channel_black_list_committed & mask;
   uint8_t given_a_chance = ((slot_number + (round_number<<3)) & 7) == 0; /* allow a black-listed channel every 8th slot */
+#if CHAOS_HOPPING_REGENERATION
+  /* the weighted sequence already visits bad channels less often */
+  given_a_chance |= WEIGHTED_SEQUENCE_IN_SLOT(slot_number);
+#endif /* CHAOS_HOPPING_REGENERATION */
   next_channel = ( blocked && !given_a_chance ) ? chaos_current_channel : next_channel;
 #endif /* CHAOS_MULTI_CHANNEL */
   return next_channel;
@@ -193,7 +277,11 @@ ALWAYS_INLINE uint16_t
 ALWAYS_INLINE uint16_t
     chaos_multichannel_update_current_channel(uint16_t round_number, uint16_t slot_number) {
 #if CHAOS_MULTI_CHANNEL
-  return chaos_current_channel = chaos_multichannel_get_next_channel(round_number, slot_number);
+  CHAOS_PROBE(CHAOS_PROBE_CHANNEL_LOOKUP, chaos_current_channel = chaos_multichannel_get_next_channel(round_number, slot_number));
+#if CHAOS_CHANNEL_STATS
+  channel_stats[CHANNEL_IDX(chaos_current_channel)].hops++;
+#endif /* CHAOS_CHANNEL_STATS */
+  return chaos_current_channel;
 #else
   return chaos_multichannel_get_next_channel(round_number, slot_number);
 #endif /* CHAOS_MULTI_CHANNEL */
@@ -208,3 +296,117 @@ ALWAYS_INLINE uint16_t
 #endif /* CHAOS_MULTI_CHANNEL */
 }
 
+
+void
+chaos_multichannel_set_group(uint8_t group) {
+#if CHAOS_CHANNEL_GROUPS > 1
+  channel_group_next = group % CHAOS_CHANNEL_GROUPS;
+#endif /* CHAOS_CHANNEL_GROUPS > 1 */
+}
+
+uint8_t
+chaos_multichannel_get_group(void) {
+#if CHAOS_CHANNEL_GROUPS > 1
+  return channel_group == CHANNEL_GROUP_UNSET ? 0 : channel_group;
+#else
+  return 0;
+#endif /* CHAOS_CHANNEL_GROUPS > 1 */
+}
+
+uint8_t
+chaos_multichannel_group_round_end(void) {
+#if CHAOS_CHANNEL_GROUPS > 1
+#if CHAOS_CHANNEL_GROUP_BRIDGE_ROUNDS
+  /* bridges carry state between the groups by visiting them in turn */
+  if(CHAOS_CHANNEL_GROUP_IS_BRIDGE(node_id) && ++channel_group_rounds >= CHAOS_CHANNEL_GROUP_BRIDGE_ROUNDS) {
+    channel_group_next = (channel_group + 1) % CHAOS_CHANNEL_GROUPS;
+  }
+#endif /* CHAOS_CHANNEL_GROUP_BRIDGE_ROUNDS */
+  return channel_group_next != channel_group;
+#else
+  return 0;
+#endif /* CHAOS_CHANNEL_GROUPS > 1 */
+}
+
+void
+chaos_multichannel_set_channel_weights(const uint8_t* weights, uint8_t epoch) {
+#if CHAOS_HOPPING_REGENERATION
+  /* smooth weighted round robin: every channel shows up in proportion to its weight,
+   * spread out over the sequence instead of in bursts */
+  int16_t current[CHAOS_NUMBER_OF_CHANNELS];
+  int16_t total = 0;
+  int i, s, best;
+  for(i = 0; i < CHAOS_NUMBER_OF_CHANNELS; i++) {
+    current[i] = 0;
+    total += weights[i];
+  }
+  if(total == 0 || epoch == 0) {
+    weighted_hopping_sequence_epoch = 0;
+    return;
+  }
+  for(s = 0; s < CHAOS_HOPPING_SEQUENCE_SIZE; s++) {
+    best = -1;
+    for(i = 0; i < CHAOS_NUMBER_OF_CHANNELS; i++) {
+      current[i] += weights[i];
+      if(weights[i] && (best < 0 || current[i] > current[best])) {
+        best = i;
+      }
+    }
+    current[best] -= total;
+    weighted_hopping_sequence[s] = RF_FIRST_CHANNEL + best;
+  }
+  weighted_hopping_sequence_epoch = epoch;
+#endif /* CHAOS_HOPPING_REGENERATION */
+}
+
+uint16_t
+chaos_multichannel_get_channel_prr(uint8_t channel_idx) {
+#if CHAOS_MULTI_CHANNEL && CHAOS_MULTI_CHANNEL_ADAPTIVE
+  return channel_idx < CHAOS_NUMBER_OF_CHANNELS ? channel_prr[channel_idx] : 0;
+#else
+  return 0;
+#endif /* CHAOS_MULTI_CHANNEL && CHAOS_MULTI_CHANNEL_ADAPTIVE */
+}
+
+const chaos_channel_stats_t*
+chaos_multichannel_get_stats(uint8_t channel_idx) {
+#if CHAOS_MULTI_CHANNEL && CHAOS_CHANNEL_STATS
+  return channel_idx < CHAOS_NUMBER_OF_CHANNELS ? &channel_stats[channel_idx] : NULL;
+#else
+  return NULL;
+#endif /* CHAOS_MULTI_CHANNEL && CHAOS_CHANNEL_STATS */
+}
+
+void
+chaos_multichannel_reset_stats(void) {
+#if CHAOS_MULTI_CHANNEL && CHAOS_CHANNEL_STATS
+  memset(channel_stats, 0, sizeof(channel_stats));
+  memset(stats_prr_avg, 0, sizeof(stats_prr_avg));
+  memset(stats_rssi_avg, 0, sizeof(stats_rssi_avg));
+#endif /* CHAOS_MULTI_CHANNEL && CHAOS_CHANNEL_STATS */
+}
+
+void
+chaos_multichannel_print_stats(uint16_t round_number) {
+#if CHAOS_MULTI_CHANNEL && CHAOS_CHANNEL_STATS
+  int i;
+  /* one line per channel: channel prr ok no_sfd hdr crc timeout other rssi hops */
+  for(i = 0; i < CHAOS_NUMBER_OF_CHANNELS; i++) {
+    const chaos_channel_stats_t* s = &channel_stats[i];
+    printf("{rd %u ch} %u %u %u %u %u %u %u %u %d %u\n", round_number, RF_FIRST_CHANNEL + i,
+        s->prr, s->rx_ok, s->rx_no_sfd, s->rx_header_error, s->rx_crc_error, s->rx_timeout, s->rx_other, s->rssi, s->hops);
+  }
+#endif /* CHAOS_MULTI_CHANNEL && CHAOS_CHANNEL_STATS */
+}
+
+uint16_t
+chaos_multichannel_get_stats_summary(uint16_t round_number) {
+#if CHAOS_MULTI_CHANNEL && CHAOS_CHANNEL_STATS
+  uint8_t channel_idx = round_number % CHAOS_NUMBER_OF_CHANNELS;
+  const chaos_channel_stats_t* s = &channel_stats[channel_idx];
+  int16_t rssi = MAX(MIN(((int16_t)s->rssi + 100) / 4, 15), 0);
+  return ((uint16_t)channel_idx << 12) | ((uint16_t)s->prr << 4) | rssi;
+#else
+  return 0;
+#endif /* CHAOS_MULTI_CHANNEL && CHAOS_CHANNEL_STATS */
+}
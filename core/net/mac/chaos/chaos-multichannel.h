@@ -50,6 +50,14 @@
 STATIC_ASSERT(!(CHAOS_HOPPING_SEQUENCE_SIZE & (CHAOS_HOPPING_SEQUENCE_SIZE-1)), "CHAOS_HOPPING_SEQUENCE_SIZE shall be a power of two so the optimization is valid %x == &(x-1)");
 #endif /* CHAOS_MULTI_CHANNEL */
 
+#if CHAOS_CHANNEL_GROUPS > 1
+#if CHAOS_MULTI_CHANNEL && (CHAOS_NUMBER_OF_CHANNELS % CHAOS_CHANNEL_GROUPS)
+#error "CHAOS_CHANNEL_GROUPS shall divide CHAOS_NUMBER_OF_CHANNELS"
+#endif
+/* move channel C of the hopping sequence into group G: keep the hopping pattern, change the index modulo the group count */
+#define CHAOS_CHANNEL_OF_GROUP(C, G) (RF_FIRST_CHANNEL + CHANNEL_IDX(C) - (CHANNEL_IDX(C) % CHAOS_CHANNEL_GROUPS) + (G))
+#endif /* CHAOS_CHANNEL_GROUPS > 1 */
+
 /* functions */
 void chaos_multichannel_init(void);
 ALWAYS_INLINE void chaos_multichannel_round_init(uint8_t is_initiator, chaos_header_t* const tx_header);
@@ -63,4 +71,39 @@ ALWAYS_INLINE uint16_t chaos_multichannel_update_current_channel(uint16_t round_
 #define HOP_CHANNEL(ROUND, SLOT) ( NETSTACK_RADIO_set_channel(chaos_multichannel_update_current_channel(ROUND, SLOT)) )
 #define CHANNEL_IDX(C) ((C)-RF_FIRST_CHANNEL)
 
+/* Weighted hopping sequence: one weight per channel (0: never), regenerates the sequence for epoch (> 0).
+ * It is used in rounds whose header carries the same epoch, except in every CHAOS_HOPPING_DEFAULT_SLOT_PERIOD-th
+ * slot: there the default sequence lets nodes with a stale sequence sync and learn the new weights.
+ * Runs in O(sequence size * channels): call it outside of the slots */
+void chaos_multichannel_set_channel_weights(const uint8_t* weights, uint8_t epoch);
+/* Link quality of a channel index as seen by this node, 0..PRR_SCALE */
+uint16_t chaos_multichannel_get_channel_prr(uint8_t channel_idx);
+
+/* Per-channel link statistics, counted since boot or the last reset */
+typedef struct {
+  uint16_t rx_ok;
+  uint16_t rx_no_sfd;
+  uint16_t rx_header_error;
+  uint16_t rx_crc_error;
+  uint16_t rx_timeout;
+  uint16_t rx_other; /* MIC errors, tx errors */
+  uint16_t hops; /* slots scheduled on the channel */
+  uint8_t prr; /* moving average of successful receptions, 0..255 */
+  int8_t rssi; /* moving average of the RSSI of valid receptions, dBm */
+} chaos_channel_stats_t;
+
+/* NULL without CHAOS_CHANNEL_STATS */
+const chaos_channel_stats_t* chaos_multichannel_get_stats(uint8_t channel_idx);
+void chaos_multichannel_reset_stats(void);
+void chaos_multichannel_print_stats(uint16_t round_number);
+/* 16-bit summary of one channel for a collect round, the channel rotates with the round number:
+ * channel index (4 bits) | PRR (8 bits) | (RSSI + 100 dBm) / 4 (4 bits) */
+uint16_t chaos_multichannel_get_stats_summary(uint16_t round_number);
+
+/* Channel groups: the new group takes effect at the next association */
+void chaos_multichannel_set_group(uint8_t group);
+uint8_t chaos_multichannel_get_group(void);
+/* Called at the end of each round: returns 1 if the node shall re-associate in another group */
+uint8_t chaos_multichannel_group_round_end(void);
+
 #endif /* CHAOS_MULTICHANNEL_H_ */
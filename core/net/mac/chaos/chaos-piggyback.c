@@ -0,0 +1,118 @@
+/*******************************************************************************
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017 Beshr Al Nahas and Olaf Landsiedel.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+/**
+ * \file
+ *         A2-Synchrotron - piggybacking of apps on the rounds of other apps.
+ *         Every app that provides a piggyback descriptor gets a fixed slice
+ *         at the front of the payload of the rounds of the other apps, so
+ *         services such as join or collect do not need rounds of their own.
+ * \author
+ *         Beshr Al Nahas <beshr@chalmers.se>
+ *         Olaf Landsiedel <olafl@chalmers.se>
+ *
+ */
+
+#include "contiki.h"
+#include "chaos.h"
+#include "chaos-control.h"
+#include "chaos-piggyback.h"
+
+#if CHAOS_PIGGYBACK
+
+static uint8_t rider_app_id[CHAOS_PIGGYBACK_MAX_RIDERS];
+static uint8_t rider_offset[CHAOS_PIGGYBACK_MAX_RIDERS];
+static uint8_t rider_count = 0;
+
+uint8_t
+chaos_piggyback_round_init(uint16_t round_number, uint8_t host_app_id, uint8_t host_payload_length, uint8_t* tx_payload)
+{
+  uint8_t length = 0;
+  int i;
+  rider_count = 0;
+  for(i = 0; i < chaos_app_count && rider_count < CHAOS_PIGGYBACK_MAX_RIDERS; i++) {
+    const chaos_piggyback_t* piggyback = chaos_apps[i]->piggyback;
+    /* all nodes run the same app list, so the layout is the same everywhere.
+     * The host payload always fits in full, riders that do not fit next to it are skipped */
+    if(i == host_app_id || piggyback == NULL
+        || host_payload_length + length + piggyback->payload_length > CHAOS_MAX_PAYLOAD_LEN) {
+      continue;
+    }
+    rider_app_id[rider_count] = i;
+    rider_offset[rider_count] = length;
+    piggyback->round_begin(round_number, tx_payload + length);
+    length += piggyback->payload_length;
+    rider_count++;
+  }
+  return length;
+}
+
+chaos_state_t
+chaos_piggyback_process(uint16_t round_number, uint16_t slot_number, chaos_state_t slot_state,
+    chaos_state_t host_state, int rx_valid, uint8_t* rx_payload, uint8_t* tx_payload)
+{
+  uint8_t* rider_flags = NULL;
+  uint8_t want_tx = 0;
+  int i;
+  for(i = 0; i < rider_count; i++) {
+    const chaos_piggyback_t* piggyback = chaos_apps[rider_app_id[i]]->piggyback;
+    chaos_state_t rider_state = piggyback->process(round_number, slot_number, slot_state, rx_valid,
+        rx_valid ? piggyback->payload_length : 0, rx_payload + rider_offset[i], tx_payload + rider_offset[i], &rider_flags);
+    want_tx |= rider_state == CHAOS_TX || rider_state == CHAOS_TX_SYNC;
+  }
+  /* the host owns the round: riders can turn an rx slot into tx, but not end or extend the round */
+  if(want_tx && host_state == CHAOS_RX) {
+    return CHAOS_TX;
+  }
+  return host_state;
+}
+
+void
+chaos_piggyback_round_end(uint16_t round_number, const uint8_t* tx_payload)
+{
+  int i;
+  for(i = 0; i < rider_count; i++) {
+    const chaos_piggyback_t* piggyback = chaos_apps[rider_app_id[i]]->piggyback;
+    if(piggyback->round_end != NULL) {
+      piggyback->round_end(round_number, tx_payload + rider_offset[i]);
+    }
+  }
+}
+
+#else /* CHAOS_PIGGYBACK */
+
+uint8_t chaos_piggyback_round_init(uint16_t round_number, uint8_t host_app_id, uint8_t host_payload_length, uint8_t* tx_payload) { return 0; }
+chaos_state_t chaos_piggyback_process(uint16_t round_number, uint16_t slot_number, chaos_state_t slot_state,
+    chaos_state_t host_state, int rx_valid, uint8_t* rx_payload, uint8_t* tx_payload) { return host_state; }
+void chaos_piggyback_round_end(uint16_t round_number, const uint8_t* tx_payload) {}
+
+#endif /* CHAOS_PIGGYBACK */
@@ -0,0 +1,77 @@
+/*******************************************************************************
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017 Beshr Al Nahas and Olaf Landsiedel.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+/**
+ * \file
+ *         A2-Synchrotron - piggybacking of apps on the rounds of other apps.
+ * \author
+ *         Beshr Al Nahas <beshr@chalmers.se>
+ *         Olaf Landsiedel <olafl@chalmers.se>
+ *
+ */
+
+#ifndef CHAOS_PIGGYBACK_H_
+#define CHAOS_PIGGYBACK_H_
+
+#include "contiki.h"
+#include "chaos.h"
+#include "chaos-config.h"
+
+/* maximum number of riders in one round */
+#ifndef CHAOS_PIGGYBACK_MAX_RIDERS
+#define CHAOS_PIGGYBACK_MAX_RIDERS 4
+#endif /* CHAOS_PIGGYBACK_MAX_RIDERS */
+
+/* An app with a piggyback descriptor rides along in the rounds of every other app (the host).
+ * Each rider owns a fixed-size sub-payload; the sub-payloads of all riders are placed
+ * in front of the host payload, in app id order. The rider process() runs on its
+ * sub-payload every slot after the host process(). The host decides when the round ends,
+ * a rider can only ask for an extra transmission by returning CHAOS_TX. */
+typedef struct chaos_piggyback {
+  uint8_t payload_length;
+  /* write the local contribution to tx_payload at round begin, on every node */
+  void (*round_begin)(const uint16_t round_count, uint8_t* tx_payload);
+  process_callback_t process;
+  /* final sub-payload of the round */
+  void (*round_end)(const uint16_t round_count, const uint8_t* payload);
+} chaos_piggyback_t;
+
+/* Round start: lay out the riders that fit next to the host_payload_length bytes of host_app_id,
+ * returns the length of their sub-payloads. The host must pass the same length on all nodes */
+uint8_t chaos_piggyback_round_init(uint16_t round_number, uint8_t host_app_id, uint8_t host_payload_length, uint8_t* tx_payload);
+/* Run the riders on their sub-payloads and merge their state into host_state */
+chaos_state_t chaos_piggyback_process(uint16_t round_number, uint16_t slot_number, chaos_state_t slot_state,
+    chaos_state_t host_state, int rx_valid, uint8_t* rx_payload, uint8_t* tx_payload);
+/* Round end: hand the final sub-payloads to the riders */
+void chaos_piggyback_round_end(uint16_t round_number, const uint8_t* tx_payload);
+
+#endif /* CHAOS_PIGGYBACK_H_ */
@@ -530,6 +530,52 @@ chaos_radio_init(void)
 #endif /* CHAOS_HW_SECURITY */
 }
 
+/*---------------------------------------------------------------------------*/
+#if CONTIKI_TARGET_SKY
+/* low-power wait: Timer A CCR2 is free on sky (CCR0: rtimer, CCR1: clock),
+ * so we use it as a compare to wake up from LPM0.
+ * LPM0 keeps the DCO running, hence timer B and the VHT stay in sync.
+ * Called from the rtimer interrupt: all other interrupt enables (clock, rtimer, UART, radio pins, SFD capture)
+ * are masked while sleeping, so nothing but the compare runs before the wakeup.
+ * Their flags stay pending and are served after the round. */
+#if CHAOS_LPM_BETWEEN_SLOTS && !CLOCK_ARCH_CCR2_WAKEUP
+#error "CHAOS_LPM_BETWEEN_SLOTS needs the clock interrupt to wake up on Timer A CCR2"
+#endif
+#define CHAOS_PLATFORM_HAS_LPM_WAIT 1
+static inline void
+chaos_platform_lpm_wait_until(rtimer_clock_t t)
+{
+  uint8_t ie1 = IE1, ie2 = IE2, p1ie = P1IE, p2ie = P2IE;
+  uint16_t ccie = (TACCTL0 & CCIE) | ((TACCTL1 & CCIE) << 1) | ((TBCCTL1 & CCIE) << 2);
+  uint16_t tacctl2 = TACCTL2;
+  IE1 = 0;
+  IE2 = 0;
+  P1IE = 0;
+  P2IE = 0;
+  TACCTL0 &= ~CCIE;
+  TACCTL1 &= ~CCIE;
+  TBCCTL1 &= ~CCIE;
+  TACCTL2 = 0;
+  TACCR2 = t;
+  TACCTL2 = CCIE;
+  /* check with interrupts disabled, then enable them together with CPUOFF
+   * so that the compare can not fire in between */
+  dint();
+  while(RTIMER_LT(RTIMER_NOW(), t)) {
+    _BIS_SR(GIE | CPUOFF);
+    dint();
+  }
+  TACCTL2 = tacctl2;
+  TACCTL0 |= ccie & CCIE;
+  TACCTL1 |= (ccie >> 1) & CCIE;
+  TBCCTL1 |= (ccie >> 2) & CCIE;
+  IE1 = ie1;
+  IE2 = ie2;
+  P1IE = p1ie;
+  P2IE = p2ie;
+}
+#endif /* CONTIKI_TARGET_SKY */
+
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
 #elif CONTIKI_TARGET_CC2538DK
@@ -548,6 +594,11 @@ chaos_radio_init(void)
 
 #endif /* CONTIKI_TARGET_SKY */
 /*---------------------------------------------------------------------------*/
+#ifndef CHAOS_PLATFORM_HAS_LPM_WAIT
+#define CHAOS_PLATFORM_HAS_LPM_WAIT 0
+/* no low-power wait support: busy wait */
+#define chaos_platform_lpm_wait_until(t) while(RTIMER_LT(RTIMER_NOW(), (t)))
+#endif /* CHAOS_PLATFORM_HAS_LPM_WAIT */
 /*---------------------------------------------------------------------------*/
 
 #endif /* CORE_NET_MAC_CHAOS_CHAOS_PLATFORM_SPECIFIC_H_ */
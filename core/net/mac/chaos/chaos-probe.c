@@ -0,0 +1,91 @@
+/*******************************************************************************
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017 Beshr Al Nahas and Olaf Landsiedel.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+/**
+ * \file
+ *         A2-Synchrotron - probe point accumulators and report.
+ * \author
+ *         Beshr Al Nahas <beshr@chalmers.se>
+ *         Olaf Landsiedel <olafl@chalmers.se>
+ *
+ */
+
+#include "contiki.h"
+#include <stdio.h>
+#include <string.h>
+#include "chaos-probe.h"
+
+#if CHAOS_PROBES
+chaos_probe_t chaos_probes[CHAOS_PROBE_COUNT];
+
+static const char* probe_names[CHAOS_PROBE_COUNT] = {
+  [CHAOS_PROBE_RADIO_WAIT] = "wait",
+  [CHAOS_PROBE_RADIO_TX] = "tx",
+  [CHAOS_PROBE_RADIO_RX] = "rx",
+  [CHAOS_PROBE_POST_RX] = "post_rx",
+  [CHAOS_PROBE_PROCESS] = "process",
+  [CHAOS_PROBE_FLAG_MERGE] = "merge",
+  [CHAOS_PROBE_CHANNEL_LOOKUP] = "channel",
+};
+#endif /* CHAOS_PROBES */
+
+void
+chaos_probe_set_name(uint8_t id, const char* name)
+{
+#if CHAOS_PROBES
+  if(id < CHAOS_PROBE_COUNT) {
+    probe_names[id] = name;
+  }
+#endif /* CHAOS_PROBES */
+}
+
+void
+chaos_probe_print(uint16_t round_number)
+{
+#if CHAOS_PROBES
+  int i;
+  printf("{rd %u probes}", round_number);
+  for(i = 0; i < CHAOS_PROBE_COUNT; i++) {
+    const chaos_probe_t* p = &chaos_probes[i];
+    if(p->count > 0) {
+      if(probe_names[i] != NULL) {
+        printf(" %s", probe_names[i]);
+      } else {
+        printf(" app%u", i - CHAOS_PROBE_KERNEL_COUNT);
+      }
+      printf(" %u %lu %lu", p->count, DCO_TO_US(p->sum), DCO_TO_US((uint32_t)p->max));
+    }
+  }
+  printf("\n");
+  memset(chaos_probes, 0, sizeof(chaos_probes));
+#endif /* CHAOS_PROBES */
+}
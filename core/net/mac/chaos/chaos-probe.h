@@ -0,0 +1,110 @@
+/*******************************************************************************
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017 Beshr Al Nahas and Olaf Landsiedel.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+/**
+ * \file
+ *         A2-Synchrotron - probe points: DCO tick accumulators (count/sum/max)
+ *         for code spans in the kernel and in apps. Compile to nothing
+ *         without CHAOS_PROBES.
+ * \author
+ *         Beshr Al Nahas <beshr@chalmers.se>
+ *         Olaf Landsiedel <olafl@chalmers.se>
+ *
+ */
+
+#ifndef CHAOS_PROBE_H_
+#define CHAOS_PROBE_H_
+
+#include "contiki.h"
+#include "chaos-config.h"
+
+/* kernel probe points, apps use CHAOS_PROBE_APP(0) .. CHAOS_PROBE_APP(CHAOS_PROBES_APP_COUNT - 1) */
+enum {
+  CHAOS_PROBE_RADIO_WAIT, /* busy wait for the radio on time of a slot, up to the last rtimer tick */
+  CHAOS_PROBE_RADIO_TX, /* radio driver transmission */
+  CHAOS_PROBE_RADIO_RX, /* radio driver reception, until a frame or the timeout */
+  CHAOS_PROBE_POST_RX, /* header checks and merge after a reception */
+  CHAOS_PROBE_PROCESS, /* app process() callback */
+  CHAOS_PROBE_FLAG_MERGE, /* flag merge in the app */
+  CHAOS_PROBE_CHANNEL_LOOKUP, /* next channel of the hopping sequence */
+  CHAOS_PROBE_KERNEL_COUNT
+};
+#define CHAOS_PROBE_APP(N) (CHAOS_PROBE_KERNEL_COUNT + (N))
+#define CHAOS_PROBE_COUNT (CHAOS_PROBE_KERNEL_COUNT + CHAOS_PROBES_APP_COUNT)
+
+#if CHAOS_PROBES
+typedef struct {
+  uint16_t count;
+  rtimer_clock_t max;
+  uint32_t sum;
+} chaos_probe_t;
+
+extern chaos_probe_t chaos_probes[CHAOS_PROBE_COUNT];
+
+static inline void
+chaos_probe_add(uint8_t id, rtimer_clock_t dco_ticks)
+{
+  chaos_probe_t* p = &chaos_probes[id];
+  p->count++;
+  p->sum += dco_ticks;
+  if(dco_ticks > p->max) {
+    p->max = dco_ticks;
+  }
+}
+
+/* span between BEGIN and END in the same scope; VAR names the span */
+#define CHAOS_PROBE_BEGIN(VAR) rtimer_clock_t chaos_probe_begin_##VAR = DCO_NOW()
+#define CHAOS_PROBE_END(VAR, ID) chaos_probe_add((ID), DCO_NOW() - chaos_probe_begin_##VAR)
+/* END with a DCO stamp taken earlier: for timing critical code, add it when there is time */
+#define CHAOS_PROBE_END_AT(VAR, ID, DCO) chaos_probe_add((ID), (DCO) - chaos_probe_begin_##VAR)
+/* span between two DCO stamps the code takes anyway */
+#define CHAOS_PROBE_ADD(ID, DCO_TICKS) chaos_probe_add((ID), (DCO_TICKS))
+/* probe a statement */
+#define CHAOS_PROBE(ID, ...) do { \
+    CHAOS_PROBE_BEGIN(statement); \
+    __VA_ARGS__; \
+    CHAOS_PROBE_END(statement, (ID)); \
+  } while(0)
+#else
+#define CHAOS_PROBE_BEGIN(VAR)
+#define CHAOS_PROBE_END(VAR, ID)
+#define CHAOS_PROBE_END_AT(VAR, ID, DCO)
+#define CHAOS_PROBE_ADD(ID, DCO_TICKS)
+#define CHAOS_PROBE(ID, ...) do { __VA_ARGS__; } while(0)
+#endif /* CHAOS_PROBES */
+
+/* name printed for an app probe point, the string must stay valid */
+void chaos_probe_set_name(uint8_t id, const char* name);
+/* one line with count, sum [us] and max [us] of every probe point that was hit, then clears them */
+void chaos_probe_print(uint16_t round_number);
+
+#endif /* CHAOS_PROBE_H_ */
@@ -54,7 +54,6 @@ unsigned int msp430_rand(void);
 //DCO_NOW()
 #endif
 
-/* TODO: make a lookup table that is updated between rounds */
 #if CHAOS_USE_MSPGCC_RAND
 #include "lib/random.h"
 uint32_t
@@ -108,36 +107,92 @@ chaos_random_generator_produce() {
 }
 #endif /* CHAOS_USE_MSPGCC_RAND */
 
-#define CHAOS_RND_TABLE_SIZE 512
+#if CHAOS_RANDOM_TABLE_SIZE > 256 || (CHAOS_RANDOM_TABLE_SIZE & (CHAOS_RANDOM_TABLE_SIZE - 1))
+#error "CHAOS_RANDOM_TABLE_SIZE must be a power of two, at most 256"
+#endif
+#define RND_TABLE_MASK (CHAOS_RANDOM_TABLE_SIZE - 1)
 static uint8_t random_idx = 0;
-static uint32_t random_table[CHAOS_RND_TABLE_SIZE] = {0UL};
+/* entries read since the last refresh: only these are refreshed between rounds */
+static uint16_t random_used = 0;
+static uint32_t random_table[CHAOS_RANDOM_TABLE_SIZE] = {0UL};
+
+static uint32_t random_seed = 0;
+static uint16_t random_stream_state[CHAOS_RANDOM_STREAM_COUNT];
 
 void
 chaos_random_generator_update_table()
 {
   random_idx = 0;
+  random_used = 0;
   int i;
-  for(i=0; i<CHAOS_RND_TABLE_SIZE; i++) {
+  for(i=0; i<CHAOS_RANDOM_TABLE_SIZE; i++) {
     random_table[i] = chaos_random_generator_produce();
   }
 
 }
 
+uint8_t
+chaos_random_generator_update_table_step(uint16_t count)
+{
+  /* refresh the consumed entries behind the read index; the read index keeps running,
+   * so a partly refreshed table does not repeat the last round */
+  while(count-- > 0 && random_used > 0) {
+    random_table[(uint8_t)(random_idx - random_used) & RND_TABLE_MASK] = chaos_random_generator_produce();
+    random_used--;
+  }
+  return random_used == 0;
+}
+
+void
+chaos_random_generator_set_stream_seed(uint8_t stream, uint16_t seed)
+{
+  if(stream < CHAOS_RANDOM_STREAM_COUNT) {
+    /* zero is the only fixed point of xorshift */
+    random_stream_state[stream] = seed ? seed : 0xace1U;
+  }
+}
+
+uint16_t
+chaos_random_generator_stream(uint8_t stream)
+{
+  uint16_t x = random_stream_state[stream];
+  x ^= x << 7;
+  x ^= x >> 9;
+  x ^= x << 8;
+  return random_stream_state[stream] = x;
+}
+
+uint32_t
+chaos_random_generator_get_seed(void)
+{
+  return random_seed;
+}
+
 void
 chaos_random_generator_init(void)
 {
-  static uint32_t random_seed = 0;
+  uint8_t i;
+#if CHAOS_RANDOM_SEED
+  random_seed = (uint32_t)CHAOS_RANDOM_SEED + ((uint32_t)node_id << 16UL);
+#else
   COOJA_DEBUG_STR("get hw random seed");
   COOJA_DEBUG_PRINTF("HW RND %lx\n", HW_RND());
   random_seed = HW_RND();
+#endif /* CHAOS_RANDOM_SEED */
   //uint16_t random_seed_l = ((node_id << 8U) | (node_id & 0xffU));
   //random_seed += random_seed_l + ((uint32_t)random_seed_l << 16UL);
   COOJA_DEBUG_PRINTF("RND %lu\n", random_seed);
   chaos_random_generator_set_seed(random_seed);
   chaos_random_generator_update_table();
+  for(i = 0; i < CHAOS_RANDOM_STREAM_COUNT; i++) {
+    chaos_random_generator_set_stream_seed(i, (uint16_t)chaos_random_generator_produce());
+  }
 }
 
 uint32_t
 chaos_random_generator_fast() {
-  return random_table[random_idx++ % CHAOS_RND_TABLE_SIZE];
+  if(random_used < CHAOS_RANDOM_TABLE_SIZE) {
+    random_used++;
+  }
+  return random_table[random_idx++ & RND_TABLE_MASK];
 }
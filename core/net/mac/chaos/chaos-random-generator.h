@@ -49,6 +49,24 @@ uint32_t chaos_random_generator_fast();
 void chaos_random_generator_set_seed(uint32_t seed);
 void chaos_random_generator_init(void);
 void chaos_random_generator_update_table();
+/* Refresh the next count entries of the table, returns 1 once the whole table is refreshed */
+uint8_t chaos_random_generator_update_table_step(uint16_t count);
+
+/* Independent streams, one per purpose, so that e.g. failure injection does not
+ * change the backoff or channel draws; all are derived from the node seed */
+enum {
+  CHAOS_RANDOM_STREAM_BACKOFF, /* restart and leader election backoff */
+  CHAOS_RANDOM_STREAM_CHANNEL, /* parallel hopping sequence offsets */
+  CHAOS_RANDOM_STREAM_TX_RATE, /* protocol tx rate reduction */
+  CHAOS_RANDOM_STREAM_FAILURES, /* FAILURES_RATE injection */
+  CHAOS_RANDOM_STREAM_COUNT
+};
+
+/* xorshift16: cheap on the 16-bit MCU, safe from the slot interrupt */
+uint16_t chaos_random_generator_stream(uint8_t stream);
+void chaos_random_generator_set_stream_seed(uint8_t stream, uint16_t seed);
+uint32_t chaos_random_generator_get_seed(void);
+#define CHAOS_RANDOM_STREAM_MAX (0xffffU)
 
 #if CHAOS_USE_MSPGCC_RAND
 #define CHAOS_RANDOM_MAX (RAND_MAX)
@@ -44,6 +44,7 @@
 #include "chaos-header.h"
 #include "chaos-control.h"
 #include "chaos-scheduler.h"
+#include "chaos-slot-calibration.h"
 #include "chaos-config.h"
 #include <project-conf.h>
 
@@ -60,7 +61,103 @@ static const chaos_app_t* current_app = NULL;
 static uint8_t current_app_id = 0;
 static const chaos_app_t* next_app = NULL;
 static uint8_t next_app_id = 0;
-static rtimer_clock_t next_round_begin = 0;
+static chaos_interval_t next_round_begin = 0;
+
+#if CHAOS_ADAPTIVE_INTERVAL
+/* Offset of the next round. Pending work: right after the longest possible
+ * current round plus the processing gap. Idle: double the interval up to the max. */
+static chaos_interval_t
+adaptive_interval(uint8_t app_id, uint8_t pending)
+{
+  static uint32_t interval = CHAOS_ADAPTIVE_INTERVAL_MAX;
+  uint32_t burst_interval = (uint32_t)chaos_apps[app_id]->max_slots * CHAOS_SLOT_LENGTH(app_id) + CHAOS_ADAPTIVE_INTERVAL_GAP;
+  interval = pending ? burst_interval : MAX(2 * interval, burst_interval);
+  interval = MIN(interval, CHAOS_ADAPTIVE_INTERVAL_MAX);
+  return interval;
+}
+#endif /* CHAOS_ADAPTIVE_INTERVAL */
+
+#if CHAOS_SCHEDULER_POLICY
+/* stride scheduling: an app advances its pass by STRIDE/weight per round it gets */
+#define SCHEDULER_STRIDE 1024
+#define ROUND_LT(A, B) ((int16_t)((A) - (B)) < 0)
+
+typedef struct {
+  uint16_t pass;
+  uint16_t last_round;  /* last round the app was scheduled for */
+  uint16_t deadline;    /* 0: none */
+  uint8_t weight;
+  uint8_t max_wait;
+} app_policy_t;
+
+static app_policy_t policy[CHAOS_SCHEDULER_MAX_APPS];
+static uint16_t global_pass = 0;
+
+void
+scheduler_set_policy(uint8_t app_id, uint8_t weight, uint8_t max_wait)
+{
+  if(app_id < CHAOS_SCHEDULER_MAX_APPS) {
+    policy[app_id].weight = weight;
+    policy[app_id].max_wait = max_wait;
+  }
+}
+
+void
+scheduler_set_deadline(uint8_t app_id, uint16_t round_count)
+{
+  if(app_id < CHAOS_SCHEDULER_MAX_APPS) {
+    policy[app_id].deadline = round_count;
+  }
+}
+
+/* Pending apps whose deadline or maximum wait falls due in round_count go first, by earliest deadline.
+ * Otherwise, the pending app with the smallest pass gets the round.
+ * Returns the app id or chaos_app_count if no app is pending */
+static int
+policy_select(const uint16_t round_count)
+{
+  int i, due = -1, fair = -1;
+  uint16_t due_deadline = 0;
+  for(i = 0; i < chaos_app_count && i < CHAOS_SCHEDULER_MAX_APPS; i++) {
+    app_policy_t* p = &policy[i];
+    if( !chaos_apps[i]->is_pending(round_count) ){
+      continue;
+    }
+    uint16_t deadline = p->deadline;
+    if(p->max_wait && (deadline == 0 || ROUND_LT(p->last_round + p->max_wait, deadline))) {
+      deadline = p->last_round + p->max_wait;
+    }
+    if(deadline != 0 && !ROUND_LT(round_count, deadline)
+        && (due < 0 || ROUND_LT(deadline, due_deadline))) {
+      due = i;
+      due_deadline = deadline;
+    }
+    /* no credit for the rounds an app was idle */
+    if(ROUND_LT(p->pass, global_pass)) {
+      p->pass = global_pass;
+    }
+    if(fair < 0 || ROUND_LT(p->pass, policy[fair].pass)) {
+      fair = i;
+    }
+  }
+  i = due >= 0 ? due : fair;
+  if(i < 0) {
+    return chaos_app_count;
+  }
+  global_pass = policy[i].pass;
+  policy[i].pass += SCHEDULER_STRIDE / MAX(policy[i].weight, 1);
+  policy[i].last_round = round_count;
+  if(policy[i].deadline != 0 && !ROUND_LT(round_count, policy[i].deadline)) {
+    policy[i].deadline = 0;
+  }
+  return i;
+}
+#else /* CHAOS_SCHEDULER_POLICY */
+
+void scheduler_set_policy(uint8_t app_id, uint8_t weight, uint8_t max_wait) {}
+void scheduler_set_deadline(uint8_t app_id, uint16_t round_count) {}
+
+#endif /* CHAOS_SCHEDULER_POLICY */
 
 void scheduler_init(){
   if( IS_INITIATOR() ){
@@ -70,7 +167,13 @@ void scheduler_init(){
         COOJA_DEBUG_PRINTF("scheduler init: app: %s", chaos_apps[i]->name);
         next_app = chaos_apps[i];
         next_app_id = i;
+#if CHAOS_LONG_INTERVAL
+        /* the first round starts right after boot, the initiator computes its start
+         * back from this interval within one rtimer period */
+        next_round_begin = MIN(CHAOS_INTERVAL, RTIMER_SECOND/2);
+#else
         next_round_begin = CHAOS_INTERVAL;
+#endif /* CHAOS_LONG_INTERVAL */
         break;
       }
     }
@@ -82,6 +185,15 @@ const chaos_app_t* scheduler_round_begin(const uint16_t round_count, uint8_t* ap
   current_app_id = next_app_id;
   if( IS_INITIATOR() && chaos_app_count > 0 ){
     int i;
+#if CHAOS_SCHEDULER_POLICY
+    i = policy_select(round_count + 1);
+    if( i < chaos_app_count ){
+      COOJA_DEBUG_PRINTF("scheduler: current app: %s, next app: %s, start %u", current_app->name, chaos_apps[i]->name, CHAOS_INTERVAL);
+      next_app = chaos_apps[i];
+      next_app_id = i;
+      next_round_begin = CHAOS_INTERVAL;
+    }
+#else
     for(i = 0; i < chaos_app_count; i++){
       if( chaos_apps[i]->is_pending(round_count + 1) ){
         COOJA_DEBUG_PRINTF("scheduler: current app: %s, next app: %s, start %u", current_app->name, chaos_apps[i]->name, CHAOS_INTERVAL);
@@ -91,6 +203,12 @@ const chaos_app_t* scheduler_round_begin(const uint16_t round_count, uint8_t* ap
         break;
       }
     }
+#endif /* CHAOS_SCHEDULER_POLICY */
+#if CHAOS_ADAPTIVE_INTERVAL
+    if( current_app != NULL ){
+      next_round_begin = adaptive_interval(current_app_id, i < chaos_app_count);
+    }
+#endif /* CHAOS_ADAPTIVE_INTERVAL */
   }
   *app_id_ptr = current_app_id;
   return current_app;
@@ -104,10 +222,10 @@ void scheduler_round_end(){
     //next_round_begin = CHAOS_INTERVAL;
     if( /*next_round_begin > 0 &&*/ next_app_id < chaos_app_count ){
       next_app = chaos_apps[next_app_id];
-      COOJA_DEBUG_PRINTF("scheduler: current app: %s, next app: %s, next begin %u", current_app ? current_app->name : "null", next_app ? next_app->name : "null", next_round_begin);
+      COOJA_DEBUG_PRINTF("scheduler: current app: %s, next app: %s, next begin %lu", current_app ? current_app->name : "null", next_app ? next_app->name : "null", (unsigned long)next_round_begin);
     } else {
       next_app = NULL;
-      PRINTF("Error: invalid data! Cannot schedule! next begin %u, next app id: %u\n", next_round_begin, next_app_id);
+      PRINTF("Error: invalid data! Cannot schedule! next begin %lu, next app id: %u\n", (unsigned long)next_round_begin, next_app_id);
     }
   }
 }
@@ -125,6 +243,6 @@ uint8_t scheduler_get_next_round_app_id(){
   return next_app_id;
 }
 
-rtimer_clock_t scheduler_get_next_round_begin(){
+chaos_interval_t scheduler_get_next_round_begin(){
   return next_round_begin;
 }
@@ -55,9 +55,19 @@ const chaos_app_t* scheduler_get_next_round_app();
 
 uint8_t scheduler_get_next_round_app_id();
 
-rtimer_clock_t scheduler_get_next_round_begin();
+chaos_interval_t scheduler_get_next_round_begin();
 
 /* correct only at round end!! */
 const chaos_app_t* scheduler_get_current_app();
 
+#define CHAOS_SCHEDULER_MAX_APPS CHAOS_MAX_APPS
+
+/* Scheduling policy of app_id (CHAOS_SCHEDULER_POLICY, initiator only).
+ * weight: share of the rounds among pending apps (default 1, 0 is treated as 1).
+ * max_wait: a pending app gets a round at least every max_wait rounds (0: no bound) */
+void scheduler_set_policy(uint8_t app_id, uint8_t weight, uint8_t max_wait);
+
+/* Schedule app_id no later than round round_count if it is pending (0: clear the deadline) */
+void scheduler_set_deadline(uint8_t app_id, uint16_t round_count);
+
 #endif /* CHAOS_SCHEDULER_H_ */
@@ -0,0 +1,130 @@
+/*******************************************************************************
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017 Beshr Al Nahas and Olaf Landsiedel.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+/**
+ * \file
+ *         A2-Synchrotron slot-length calibration.
+ *         Every node measures the busy part of its slots (prepare, tx/rx,
+ *         post-processing and app processing) and aggregates the maximum
+ *         in the header. The initiator derives the slot length from the
+ *         maxima of the last rounds plus a margin and announces it in the
+ *         header of the next round of the app.
+ * \author
+ *         Beshr Al Nahas <beshr@chalmers.se>
+ *         Olaf Landsiedel <olafl@chalmers.se>
+ *
+ */
+
+#include "contiki.h"
+#include "chaos.h"
+#include "chaos-control.h"
+#include "chaos-platform-specific.h"
+#include "chaos-slot-calibration.h"
+
+#if CHAOS_SLOT_CALIBRATION
+
+/* 0: use the configured slot length of the app */
+static uint16_t slot_length[CHAOS_SLOT_CALIBRATION_MAX_APPS] = {0};
+static uint8_t busy_max_collected[CHAOS_SLOT_CALIBRATION_MAX_APPS] = {0};
+static uint8_t rounds_collected[CHAOS_SLOT_CALIBRATION_MAX_APPS] = {0};
+static uint8_t round_busy_max = 0;
+static chaos_header_t* tx_header_ptr = NULL;
+
+uint16_t
+chaos_slot_calibration_get_slot_length(uint8_t app_id) {
+  if(app_id < CHAOS_SLOT_CALIBRATION_MAX_APPS && slot_length[app_id] != 0) {
+    return slot_length[app_id];
+  }
+  return chaos_apps[app_id]->slot_length;
+}
+
+uint8_t
+chaos_slot_calibration_get_round_busy_max(void) {
+  return round_busy_max;
+}
+
+void
+chaos_slot_calibration_round_init(uint8_t is_initiator, uint8_t app_id, chaos_header_t* const tx_header) {
+  tx_header_ptr = tx_header;
+  round_busy_max = 0;
+  tx_header->slot_busy_max = 0;
+  /* a non-initiator relays the value of the initiator once it receives it */
+  tx_header->slot_length = is_initiator ? chaos_slot_calibration_get_slot_length(app_id) : 0;
+}
+
+void
+chaos_slot_calibration_rx(uint8_t app_id, const chaos_header_t* const rx_header) {
+  if(CHAOS_HEADER_GET_APP_ID(rx_header) != app_id || app_id >= CHAOS_SLOT_CALIBRATION_MAX_APPS) {
+    return;
+  }
+  if(rx_header->slot_length != 0) {
+    slot_length[app_id] = rx_header->slot_length;
+    tx_header_ptr->slot_length = rx_header->slot_length;
+  }
+  round_busy_max = MAX(round_busy_max, rx_header->slot_busy_max);
+  tx_header_ptr->slot_busy_max = round_busy_max;
+}
+
+void
+chaos_slot_calibration_add_slot(rtimer_clock_t busy_dco) {
+  /* round up and saturate */
+  uint16_t busy = DCO_TO_RTIMER(busy_dco) + 1;
+  busy = MIN(busy, 0xff);
+  round_busy_max = MAX(round_busy_max, busy);
+  tx_header_ptr->slot_busy_max = round_busy_max;
+}
+
+void
+chaos_slot_calibration_round_end(uint8_t is_initiator, uint8_t app_id) {
+  if(!is_initiator || app_id >= CHAOS_SLOT_CALIBRATION_MAX_APPS || round_busy_max == 0) {
+    return;
+  }
+  busy_max_collected[app_id] = MAX(busy_max_collected[app_id], round_busy_max);
+  if(++rounds_collected[app_id] >= CHAOS_SLOT_CALIBRATION_ROUNDS) {
+    /* the configured slot length is the upper bound */
+    uint16_t new_slot_length = busy_max_collected[app_id] + RTIMER_MIN_DELAY + CHAOS_SLOT_CALIBRATION_MARGIN;
+    slot_length[app_id] = MIN(new_slot_length, chaos_apps[app_id]->slot_length);
+    busy_max_collected[app_id] = 0;
+    rounds_collected[app_id] = 0;
+  }
+}
+
+#else /* CHAOS_SLOT_CALIBRATION */
+
+uint16_t chaos_slot_calibration_get_slot_length(uint8_t app_id) { return chaos_apps[app_id]->slot_length; }
+uint8_t chaos_slot_calibration_get_round_busy_max(void) { return 0; }
+void chaos_slot_calibration_round_init(uint8_t is_initiator, uint8_t app_id, chaos_header_t* const tx_header) {}
+void chaos_slot_calibration_rx(uint8_t app_id, const chaos_header_t* const rx_header) {}
+void chaos_slot_calibration_add_slot(rtimer_clock_t busy_dco) {}
+void chaos_slot_calibration_round_end(uint8_t is_initiator, uint8_t app_id) {}
+
+#endif /* CHAOS_SLOT_CALIBRATION */
@@ -0,0 +1,82 @@
+/*******************************************************************************
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017 Beshr Al Nahas and Olaf Landsiedel.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+/**
+ * \file
+ *         A2-Synchrotron slot-length calibration.
+ * \author
+ *         Beshr Al Nahas <beshr@chalmers.se>
+ *         Olaf Landsiedel <olafl@chalmers.se>
+ *
+ */
+
+#ifndef CHAOS_SLOT_CALIBRATION_H_
+#define CHAOS_SLOT_CALIBRATION_H_
+
+#include "contiki.h"
+#include "chaos-config.h"
+#include "chaos-header.h"
+
+/* rounds of measurements the initiator collects before updating the slot length */
+#ifndef CHAOS_SLOT_CALIBRATION_ROUNDS
+#define CHAOS_SLOT_CALIBRATION_ROUNDS 4
+#endif /* CHAOS_SLOT_CALIBRATION_ROUNDS */
+
+/* safety margin added to the longest measured busy part of a slot, in rtimer ticks */
+#ifndef CHAOS_SLOT_CALIBRATION_MARGIN
+#define CHAOS_SLOT_CALIBRATION_MARGIN (RTIMER_SECOND/2000)
+#endif /* CHAOS_SLOT_CALIBRATION_MARGIN */
+
+#define CHAOS_SLOT_CALIBRATION_MAX_APPS CHAOS_MAX_APPS
+
+/* Round start: the initiator announces the slot length of app_id in tx_header */
+void chaos_slot_calibration_round_init(uint8_t is_initiator, uint8_t app_id, chaos_header_t* const tx_header);
+/* Valid packet of the current round: adopt its slot length and merge its busy time */
+void chaos_slot_calibration_rx(uint8_t app_id, const chaos_header_t* const rx_header);
+/* Own busy time of a slot, from slot start until the wait for the next slot, in DCO ticks */
+void chaos_slot_calibration_add_slot(rtimer_clock_t busy_dco);
+/* Round end: the initiator updates the slot length of app_id from the collected maxima */
+void chaos_slot_calibration_round_end(uint8_t is_initiator, uint8_t app_id);
+/* Current slot length of app_id, in rtimer ticks */
+uint16_t chaos_slot_calibration_get_slot_length(uint8_t app_id);
+/* Longest busy part of a slot seen in the last round, in rtimer ticks */
+uint8_t chaos_slot_calibration_get_round_busy_max(void);
+
+#if CHAOS_SLOT_CALIBRATION
+#define CHAOS_SLOT_LENGTH(APP_ID) (chaos_slot_calibration_get_slot_length(APP_ID))
+#define CHAOS_HEADER_SLOT_LENGTH(HEADER, APP) ((HEADER)->slot_length)
+#else
+#define CHAOS_SLOT_LENGTH(APP_ID) (chaos_apps[(APP_ID)]->slot_length)
+#define CHAOS_HEADER_SLOT_LENGTH(HEADER, APP) ((APP)->slot_length)
+#endif /* CHAOS_SLOT_CALIBRATION */
+
+#endif /* CHAOS_SLOT_CALIBRATION_H_ */
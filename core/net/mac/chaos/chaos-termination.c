@@ -0,0 +1,111 @@
+/*******************************************************************************
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017 Beshr Al Nahas and Olaf Landsiedel.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+/**
+ * \file
+ *         A2-Synchrotron online adaptation of the final flood and restart thresholds.
+ * \author
+ *         Beshr Al Nahas <beshr@chalmers.se>
+ *         Olaf Landsiedel <olafl@chalmers.se>
+ *
+ */
+
+#include "contiki.h"
+#include "chaos.h"
+#include "chaos-random-generator.h"
+#include "chaos-termination.h"
+
+#if CHAOS_ADAPTIVE_TERMINATION
+
+#define EWMA_ONE (0xffffU)
+#define EWMA_UPDATE(AVG, SAMPLE) \
+  ((AVG) = (uint16_t)((int32_t)(AVG) + (((int32_t)((SAMPLE) ? EWMA_ONE : 0) - (int32_t)(AVG)) >> CHAOS_ADAPTIVE_TERMINATION_EWMA_SHIFT)))
+
+/* start from the middle: this gives the configured thresholds until we learn better */
+static uint16_t rx_success = EWMA_ONE / 2;
+static uint16_t neighbor_lacks = EWMA_ONE / 2;
+
+void
+chaos_termination_rx_slot(uint8_t success) {
+  EWMA_UPDATE(rx_success, success);
+}
+
+void
+chaos_termination_rx_complete(uint8_t neighbor_lacks_final) {
+  EWMA_UPDATE(neighbor_lacks, neighbor_lacks_final);
+}
+
+uint8_t
+chaos_termination_get_rx_success(void) {
+  return rx_success >> 8;
+}
+
+uint8_t
+chaos_termination_get_neighbor_lacks(void) {
+  return neighbor_lacks >> 8;
+}
+
+uint8_t
+chaos_termination_get_n_tx_complete(uint8_t n_tx_complete) {
+  /* a lagging neighbor or lossy links: keep flooding longer.
+   * Dense and reliable: both are low and we go off sooner */
+  uint8_t risk = MAX(chaos_termination_get_neighbor_lacks(), 255 - chaos_termination_get_rx_success());
+  uint16_t n_mid = MAX((uint16_t)n_tx_complete, CHAOS_ADAPTIVE_TERMINATION_N_TX_MIN);
+  /* two linear pieces, so that the initial estimate (risk 128) gives exactly n_tx_complete */
+  if(risk <= 128) {
+    return CHAOS_ADAPTIVE_TERMINATION_N_TX_MIN + (((n_mid - CHAOS_ADAPTIVE_TERMINATION_N_TX_MIN) * risk) >> 7);
+  }
+  return n_mid + ((n_mid * (risk - 128)) >> 7);
+}
+
+uint8_t
+chaos_termination_get_restart_threshold(uint8_t restart_min, uint8_t restart_max) {
+  /* the expected run of lost slots grows with 1/success rate:
+   * silence means more on a reliable link, so restart sooner there */
+  uint16_t success = MAX(chaos_termination_get_rx_success(), 16);
+  uint16_t scaled_min = ((uint16_t)restart_min * 128) / success;
+  scaled_min = MAX(MIN(scaled_min, restart_max), 1);
+  return MIN(scaled_min + chaos_random_generator_fast() % (restart_max - restart_min), restart_max);
+}
+
+#else /* CHAOS_ADAPTIVE_TERMINATION */
+
+void chaos_termination_rx_slot(uint8_t success) {}
+void chaos_termination_rx_complete(uint8_t neighbor_lacks_final) {}
+uint8_t chaos_termination_get_rx_success(void) { return 0; }
+uint8_t chaos_termination_get_neighbor_lacks(void) { return 0; }
+uint8_t chaos_termination_get_n_tx_complete(uint8_t n_tx_complete) { return n_tx_complete; }
+uint8_t chaos_termination_get_restart_threshold(uint8_t restart_min, uint8_t restart_max) {
+  return chaos_random_generator_fast() % (restart_max - restart_min) + restart_min;
+}
+
+#endif /* CHAOS_ADAPTIVE_TERMINATION */
@@ -0,0 +1,78 @@
+/*******************************************************************************
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017 Beshr Al Nahas and Olaf Landsiedel.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+/**
+ * \file
+ *         A2-Synchrotron online adaptation of the final flood and restart thresholds.
+ * \author
+ *         Beshr Al Nahas <beshr@chalmers.se>
+ *         Olaf Landsiedel <olafl@chalmers.se>
+ *
+ */
+
+#ifndef CHAOS_TERMINATION_H_
+#define CHAOS_TERMINATION_H_
+
+#include "contiki.h"
+#include "chaos-config.h"
+#include "chaos-random-generator.h"
+
+/* weight of a new sample in the moving averages: 1/2^SHIFT */
+#ifndef CHAOS_ADAPTIVE_TERMINATION_EWMA_SHIFT
+#define CHAOS_ADAPTIVE_TERMINATION_EWMA_SHIFT 4
+#endif /* CHAOS_ADAPTIVE_TERMINATION_EWMA_SHIFT */
+
+/* Called by the kernel: outcome of a synced rx slot */
+void chaos_termination_rx_slot(uint8_t success);
+/* Called by the apps: valid rx after completion, did the neighbor still lack the final state? */
+void chaos_termination_rx_complete(uint8_t neighbor_lacks);
+/* Final flood length, between CHAOS_ADAPTIVE_TERMINATION_N_TX_MIN and about 2*n_tx_complete,
+ * n_tx_complete itself until the averages move */
+uint8_t chaos_termination_get_n_tx_complete(uint8_t n_tx_complete);
+/* Silent slots before retransmitting, drawn from a window scaled by the slot success rate, at most restart_max */
+uint8_t chaos_termination_get_restart_threshold(uint8_t restart_min, uint8_t restart_max);
+/* Moving averages scaled to 0..255 */
+uint8_t chaos_termination_get_rx_success(void);
+uint8_t chaos_termination_get_neighbor_lacks(void);
+
+/* Drop-in replacements for the compile-time N_TX_COMPLETE, CHAOS_RESTART_MIN and CHAOS_RESTART_MAX of the apps */
+#if CHAOS_ADAPTIVE_TERMINATION
+#define CHAOS_N_TX_COMPLETE() (chaos_termination_get_n_tx_complete(N_TX_COMPLETE))
+#define CHAOS_RESTART_THRESHOLD() (chaos_termination_get_restart_threshold(CHAOS_RESTART_MIN, CHAOS_RESTART_MAX))
+#define CHAOS_TERMINATION_RX_COMPLETE(LACKS) chaos_termination_rx_complete(LACKS)
+#else
+#define CHAOS_N_TX_COMPLETE() (N_TX_COMPLETE)
+#define CHAOS_RESTART_THRESHOLD() (chaos_random_generator_fast() % (CHAOS_RESTART_MAX - CHAOS_RESTART_MIN) + CHAOS_RESTART_MIN)
+#define CHAOS_TERMINATION_RX_COMPLETE(LACKS)
+#endif /* CHAOS_ADAPTIVE_TERMINATION */
+
+#endif /* CHAOS_TERMINATION_H_ */
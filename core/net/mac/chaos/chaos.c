@@ -62,6 +62,11 @@
 #include "node.h"
 #include "chaos-control.h"
 #include "chaos-random-generator.h"
+#include "chaos-drift.h"
+#include "chaos-slot-calibration.h"
+#include "chaos-probe.h"
+#include "chaos-piggyback.h"
+#include "chaos-termination.h"
 
 #define CHAOS_TX_RTIMER_GUARD 1
 #define CHAOS_RX_RTIMER_GUARD 1
@@ -102,24 +107,103 @@ static uint8_t * const rx_packet = (uint8_t *) rx_packet_32t;
 static chaos_header_t* const tx_header = (chaos_header_t*)tx_packet_32t;
 static chaos_header_t* const rx_header = (chaos_header_t*)rx_packet_32t;
 
-uint8_t chaos_slot_log[MAX_SLOTS_IN_ROUND] = {0};
+#if CHAOS_HEADER_COMPRESSION
+/* tx_packet stays the full frame the apps work on, the compact copy is what goes on the air */
+static uint32_t tx_compact_packet_32t[(RADIO_MAX_PACKET_LEN + 3)/ 4];
+static chaos_header_t* const tx_compact_header = (chaos_header_t*)tx_compact_packet_32t;
+static uint8_t tx_compact = 0;
+
+/* the initiator always sends full headers; others after the first slots, except periodically */
+#define CHAOS_HEADER_COMPACT_SLOT(SLOT) (!IS_INITIATOR() && (SLOT) >= CHAOS_HEADER_FULL_SLOTS \
+    && (CHAOS_HEADER_FULL_PERIOD == 0 || (SLOT) % CHAOS_HEADER_FULL_PERIOD != 0))
+
+/* build the compact frame: drop the round-constant fields and mark the round by its epoch */
+static void
+chaos_header_compress(void)
+{
+  memcpy(tx_compact_packet_32t, tx_packet_32t, CHAOS_HEADER_ROUND_INFO_OFFSET);
+  memcpy((uint8_t*)tx_compact_header + CHAOS_HEADER_ROUND_INFO_OFFSET, tx_header->payload, CHAOS_PAYLOAD_LENGTH(tx_header));
+  tx_compact_header->epoch = CHAOS_HEADER_EPOCH_COMPACT | CHAOS_HEADER_EPOCH(INITIATOR_NODE_ID, tx_header->round_number);
+  tx_compact_header->length = tx_header->length - CHAOS_HEADER_ROUND_INFO_LEN;
+}
+
+/* restore a compact rx frame in place, taking the round-constant fields from our own header */
+static int
+chaos_header_expand(void)
+{
+  if((rx_header->epoch & ~CHAOS_HEADER_EPOCH_COMPACT) != CHAOS_HEADER_EPOCH(INITIATOR_NODE_ID, rx_header->round_number)) {
+    return CHAOS_TXRX_OK_FOREIGN_CLUSTER;
+  }
+  if(rx_header->length + CHAOS_HEADER_ROUND_INFO_LEN >= RADIO_MAX_PACKET_LEN) {
+    return CHAOS_RX_HEADER_ERROR;
+  }
+  /* payload, MIC and footer move up; the length byte itself is not counted in length */
+  memmove(rx_header->payload, (uint8_t*)rx_header + CHAOS_HEADER_ROUND_INFO_OFFSET, rx_header->length + 1 - CHAOS_HEADER_ROUND_INFO_OFFSET);
+  memcpy((uint8_t*)rx_header + CHAOS_HEADER_ROUND_INFO_OFFSET, (uint8_t*)tx_header + CHAOS_HEADER_ROUND_INFO_OFFSET, CHAOS_HEADER_ROUND_INFO_LEN);
+  rx_header->length += CHAOS_HEADER_ROUND_INFO_LEN;
+  rx_header->epoch &= ~CHAOS_HEADER_EPOCH_COMPACT;
+  return CHAOS_TXRX_OK;
+}
+#endif /* CHAOS_HEADER_COMPRESSION */
+
+uint8_t chaos_slot_log[CHAOS_SLOT_LOG_SIZE] = {0};
 rtimer_clock_t chaos_slot_timing_log_max[SLOT_TIMING_SIZE] = {0};
 rtimer_clock_t chaos_slot_timing_log_min[SLOT_TIMING_SIZE] = {0};
 rtimer_clock_t chaos_slot_timing_log_current[SLOT_TIMING_SIZE] = {0};
 uint32_t chaos_slot_timing_rx_sum = 0;
 uint32_t chaos_slot_timing_tx_sum = 0;
+#if CHAOS_SLOT_TIMING_HISTOGRAM
+uint16_t chaos_slot_timing_histogram[CHAOS_SLOT_TIMING_HISTOGRAM_APPS][SLOTNUMBER][CHAOS_SLOT_TIMING_HISTOGRAM_BUCKETS] = {{{0}}};
+
+static ALWAYS_INLINE uint8_t
+slot_timing_bucket(rtimer_clock_t t)
+{
+  uint8_t bucket = 0;
+  t >>= CHAOS_SLOT_TIMING_HISTOGRAM_SHIFT;
+  while(t && bucket < CHAOS_SLOT_TIMING_HISTOGRAM_BUCKETS - 1) {
+    t >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+#define SLOT_TIMING_HISTOGRAM_ADD(PHASE) \
+  (chaos_slot_timing_histogram[MIN(app_id, CHAOS_SLOT_TIMING_HISTOGRAM_APPS - 1)][(PHASE)][slot_timing_bucket(chaos_slot_timing_log_current[(PHASE)])]++)
+#else
+#define SLOT_TIMING_HISTOGRAM_ADD(PHASE)
+#endif /* CHAOS_SLOT_TIMING_HISTOGRAM */
+/* fold the current measurement of a timing phase into the round profile */
+#define SLOT_TIMING_LOG(PHASE) \
+  do { \
+    chaos_slot_timing_log_max[(PHASE)] = MAX(chaos_slot_timing_log_current[(PHASE)], chaos_slot_timing_log_max[(PHASE)]); \
+    chaos_slot_timing_log_min[(PHASE)] = MIN(chaos_slot_timing_log_current[(PHASE)], chaos_slot_timing_log_min[(PHASE)]); \
+    SLOT_TIMING_HISTOGRAM_ADD(PHASE); \
+  } while(0)
 
 uint16_t chaos_slot_stats[CHAOS_SLOT_STATS_SIZE] = {0};
+#if CHAOS_SLOT_OVERRUN_DETECTION
+static uint16_t chaos_slot_overruns[CHAOS_MAX_APPS] = {0};
+#endif /* CHAOS_SLOT_OVERRUN_DETECTION */
+#if CHAOS_ENERGY_ACCOUNTING
+static chaos_energy_t chaos_energy_round;
+static chaos_energy_t chaos_energy_app[CHAOS_MAX_APPS];
+static rtimer_clock_t t_radio_on_dco;
+/* set after the radio slot from a stamp the timing path takes anyway, not in between */
+#define ENERGY_RADIO_ON(DCO) (t_radio_on_dco = (DCO))
+#define ENERGY_ADD(FIELD, DCO_TICKS) (chaos_energy_round.FIELD += (DCO_TICKS))
+#else
+#define ENERGY_RADIO_ON(DCO)
+#define ENERGY_ADD(FIELD, DCO_TICKS)
+#endif /* CHAOS_ENERGY_ACCOUNTING */
 #define SET_SLOT_STATUS(SLOT, RXTX, SUCCESS) \
   do { \
     if((RXTX) == CHAOS_TX){ \
-      chaos_slot_log[SLOT] = ((SUCCESS) == CHAOS_TXRX_OK) ? 12 : 11;  \
+      CHAOS_SLOT_LOG_SET(SLOT, ((SUCCESS) == CHAOS_TXRX_OK) ? 12 : 11);  \
     } else if((RXTX) == CHAOS_RX){ \
-      chaos_slot_log[SLOT] = (SUCCESS);  \
+      CHAOS_SLOT_LOG_SET(SLOT, (SUCCESS));  \
     } else { \
-      chaos_slot_log[SLOT] = 10;  \
+      CHAOS_SLOT_LOG_SET(SLOT, 10);  \
     } \
-    chaos_slot_stats[chaos_slot_log[SLOT] % CHAOS_SLOT_STATS_SIZE]++; \
+    chaos_slot_stats[CHAOS_SLOT_LOG_GET(SLOT) % CHAOS_SLOT_STATS_SIZE]++; \
   } while(0)
 
 static uint8_t* app_flags = 0;
@@ -131,15 +215,53 @@ static int flag_delta = 0;
  * that were reading wrong values
  */
 volatile static int round_synced = 0;
+#if CHAOS_FAST_RESYNC
+/* widened listen window of the round-start slot of an unsynced node, 0 after that slot */
+static rtimer_clock_t round_start_guard = 0;
+#define ROUND_START_GUARD_TIME (round_start_guard)
+#else
+#define ROUND_START_GUARD_TIME (0)
+#endif /* CHAOS_FAST_RESYNC */
 volatile static uint16_t sync_round = 0;
 volatile static uint8_t next_round_id = 0;
-volatile static rtimer_clock_t next_round_begin = 0, t_slot_start_dco = 0;
+volatile static chaos_interval_t next_round_begin = 0;
+volatile static rtimer_clock_t t_slot_start_dco = 0;
 volatile static rtimer_clock_t round_offset_to_radio_on = 0;
 volatile static vht_clock_t  round_rtimer = 0,
     round_offset_to_radio_on_vht = 0,
     round_start = 0;
 static vht_clock_t t_slot_start = 0;
 
+#if CHAOS_CO_INITIATORS
+static const uint16_t co_initiator_ids[] = { CHAOS_CO_INITIATOR_IDS };
+/* active: we start the current round; heard: we received from the network in the current round;
+ * resync: re-anchor our round start on the first reception */
+static uint8_t co_initiator_active = 0, co_initiator_heard = 0, co_initiator_resync = 0;
+
+uint8_t chaos_is_co_initiator(uint16_t id){
+  uint8_t i;
+  for(i = 0; i < sizeof(co_initiator_ids)/sizeof(co_initiator_ids[0]); i++){
+    if(co_initiator_ids[i] == id){
+      return 1;
+    }
+  }
+  return 0;
+}
+
+uint8_t chaos_co_initiator_is_active(void){
+  return co_initiator_active;
+}
+
+/* slot-0 schedule of the initiator and of every active co-initiator: the current round repeats.
+ * All of them send the same header in slot 0, the initiator announces its own schedule afterwards */
+static void
+co_initiator_set_default_schedule(uint8_t app_id){
+  CHAOS_HEADER_SET_NEXT_ROUND_ID(tx_header, app_id);
+  tx_header->next_round_start = CHAOS_INTERVAL_ENCODE(chaos_control_get_current_round_begin());
+  tx_header->schedule_from_initiator = 0;
+}
+#endif /* CHAOS_CO_INITIATORS */
+
 /* lower is better */
 static uint8_t chaos_rank = CHAOS_MAX_RANK;
 /* lower is better */
@@ -315,13 +437,18 @@ packet_input(void)
 static ALWAYS_INLINE uint8_t
 chaos_tx_slot(rtimer_clock_t* sfd_dco){
   uint8_t tx_status = 0;
+#if CHAOS_HEADER_COMPRESSION
+  chaos_header_t* const air_header = tx_compact ? tx_compact_header : tx_header;
+#else
+  chaos_header_t* const air_header = tx_header;
+#endif /* CHAOS_HEADER_COMPRESSION */
   LEDS_ON(LEDS_GREEN);
   /* block until tx ends */
-  tx_status = NETSTACK_RADIO_fast_send(tx_packet, (uint16_t*)sfd_dco);
+  tx_status = NETSTACK_RADIO_fast_send((uint8_t*)air_header, (uint16_t*)sfd_dco);
 
 //  tx_status = chaos_random_generator_fast()+2;
   if(tx_status) {
-    BUSYWAIT_UNTIL(!CC2420_SFD_IS_1, CHAOS_PACKET_DURATION(CHAOS_PACKET_RADIO_LENGTH(tx_header->length)));
+    BUSYWAIT_UNTIL(!CC2420_SFD_IS_1, CHAOS_PACKET_DURATION(CHAOS_PACKET_RADIO_LENGTH(air_header->length)));
   }
   LEDS_OFF(LEDS_GREEN);
   return tx_status ? CHAOS_TXRX_OK : CHAOS_TXRX_ERROR;
@@ -337,7 +464,7 @@ chaos_post_rx(int rx_state, uint8_t app_id, int round_synced, uint16_t round_num
   flag_delta = 0;
   if(rx_state == CHAOS_TXRX_OK) {
     if(INITIATOR_NODE_ID == rx_header->initiator_id){
-      if(app_id == rx_header->id) {
+      if(app_id == CHAOS_HEADER_GET_APP_ID(rx_header)) {
         //COOJA_DEBUG_STR("valid packet");
         /* Processing */
         //TODO: some more header processing
@@ -348,9 +475,20 @@ chaos_post_rx(int rx_state, uint8_t app_id, int round_synced, uint16_t round_num
   #if CHAOS_USE_SRC_ID
         tx_header->src_node_id = node_id;
   #endif
-        tx_header->id = rx_header->id;
-        next_round_id = tx_header->next_round_id = rx_header->next_round_id;
-        next_round_begin = tx_header->next_round_start = rx_header->next_round_start;
+        CHAOS_HEADER_SET_APP_ID(tx_header, CHAOS_HEADER_GET_APP_ID(rx_header));
+#if CHAOS_CO_INITIATORS
+        /* the schedule of the initiator overrides the default schedule of the co-initiators.
+         * The initiator keeps its own, even before it is in its header */
+        if(!IS_INITIATOR() && (rx_header->schedule_from_initiator || !tx_header->schedule_from_initiator))
+#endif /* CHAOS_CO_INITIATORS */
+        {
+          next_round_id = CHAOS_HEADER_GET_NEXT_ROUND_ID(rx_header);
+          CHAOS_HEADER_SET_NEXT_ROUND_ID(tx_header, next_round_id);
+          next_round_begin = CHAOS_INTERVAL_DECODE(tx_header->next_round_start = rx_header->next_round_start);
+#if CHAOS_CO_INITIATORS
+          tx_header->schedule_from_initiator = rx_header->schedule_from_initiator;
+#endif /* CHAOS_CO_INITIATORS */
+        }
 
         //tx_header->leave |= rx_header->leave;
       } else {
@@ -377,11 +515,23 @@ chaos_rx_slot(vht_clock_t* sfd_vht, int round_synced, uint8_t app_id, uint8_t as
 {
 	//COOJA_DEBUG_STR("RX slot begin");
   int rx_state = CHAOS_TXRX_UNKOWN;
-  rtimer_clock_t slot_length = (association) ? (ASSOCIATION_SLOT_LEN + ((chaos_random_generator_fast() > CHAOS_RANDOM_MAX/2) ? ASSOCIATION_SLOT_LEN / 8 : 0)) : chaos_apps[app_id]->slot_length; //in rtimer ticks
+  rtimer_clock_t slot_length = (association) ? (ASSOCIATION_SLOT_LEN + ((chaos_random_generator_fast() > CHAOS_RANDOM_MAX/2) ? ASSOCIATION_SLOT_LEN / 8 : 0)) : CHAOS_SLOT_LENGTH(app_id); //in rtimer ticks
+  /* how long an unsynced node waits for the SFD */
+  rtimer_clock_t round_guard = MAX(ROUND_GUARD_TIME, ROUND_START_GUARD_TIME);
   NETSTACK_RADIO_flushrx();
   LEDS_ON(LEDS_GREEN);
   SET_PIN_ADC2;
-	rx_state = NETSTACK_RADIO_fast_rx(sfd_vht, round_synced, app_id, association, rx_packet, slot_length);
+	rx_state = NETSTACK_RADIO_fast_rx(sfd_vht, round_synced, app_id, association, rx_packet, slot_length, round_guard);
+#if CHAOS_HEADER_COMPRESSION
+  if(rx_state == CHAOS_TXRX_OK && CHAOS_HEADER_IS_COMPACT(rx_header)) {
+    /* compact frames lack the round information needed to (re)sync */
+    rx_state = (association || !round_synced) ? CHAOS_RX_HEADER_ERROR : chaos_header_expand();
+  } else if(rx_state == CHAOS_TXRX_OK
+      && rx_header->length < sizeof(chaos_header_t) + FOOTER_LEN + LLSEC802154_MIC_LENGTH) {
+    /* the radio only checked the compact minimum */
+    rx_state = CHAOS_RX_HEADER_ERROR;
+  }
+#endif /* CHAOS_HEADER_COMPRESSION */
 //	rx_state = chaos_random_generator_fast()+2;
 	UNSET_PIN_ADC1;
   LEDS_OFF(LEDS_GREEN);
@@ -413,6 +563,7 @@ chaos_do_tx( void ){
   t_go_dco_delay = t_go_goal_vht_rtimer_dco.dco + RTIMER_TO_DCO(CHAOS_TX_RTIMER_GUARD);
 
   //wait until we get there
+  CHAOS_PROBE_BEGIN(wait);
   while(RTIMER_LT(RTIMER_NOW(), t_go_rtimer));
   on();
   //wait for the last tick using the faster unsafe function
@@ -429,6 +580,10 @@ chaos_do_tx( void ){
   off();
 #endif
   t_txrx_end = DCO_NOW();
+  /* probes from the stamps above: nothing may run between the waits and the radio call */
+  CHAOS_PROBE_END_AT(wait, CHAOS_PROBE_RADIO_WAIT, call_dco_delay);
+  CHAOS_PROBE_ADD(CHAOS_PROBE_RADIO_TX, t_txrx_end - call_dco);
+  ENERGY_RADIO_ON(call_dco_delay);
   t_go_actual = RTIMER_DCO_TO_VHT(wait_end_rtimer, call_dco-wait_end_dco);
   t_sfd_actual = RTIMER_DCO_TO_VHT(wait_end_rtimer, sfd_dco-wait_end_dco);
   t_sfd_goal_log = t_sfd_goal;
@@ -445,7 +600,7 @@ chaos_do_rx( const uint8_t app_id ){
   if(round_synced) {
     t_go_goal = t_sfd_goal - RTIMER_TO_VHT(RX_GUARD_TIME / 2) - CHAOS_RX_DELAY_VHT;
   } else {
-    t_go_goal = t_sfd_goal - RTIMER_TO_VHT(ROUND_GUARD_TIME / 2) - CHAOS_RX_DELAY_VHT;
+    t_go_goal = t_sfd_goal - RTIMER_TO_VHT(MAX(CHAOS_DRIFT_ROUND_GUARD_TIME, ROUND_START_GUARD_TIME) / 2) - CHAOS_RX_DELAY_VHT;
   }
 
   t_go_goal_vht_rtimer_dco = vht_to_vht_rtimer_dco(t_go_goal);
@@ -453,6 +608,7 @@ chaos_do_rx( const uint8_t app_id ){
   t_go_dco_delay = t_go_goal_vht_rtimer_dco.dco + RTIMER_TO_DCO(CHAOS_RX_RTIMER_GUARD);
 
   //wait until we get there
+  CHAOS_PROBE_BEGIN(wait);
   while(RTIMER_LT(RTIMER_NOW(), t_go_rtimer));
   on();
   //wait for the last tick using the faster unsafe function
@@ -465,16 +621,71 @@ chaos_do_rx( const uint8_t app_id ){
   call_dco = DCO_NOW();
   //go
   status = chaos_rx_slot(&t_sfd_actual, round_synced, app_id, 0);
+#if CHAOS_FAST_RESYNC
+  /* the next unsynced slots are aligned to this one: back to the normal guard */
+  round_start_guard = 0;
+#endif /* CHAOS_FAST_RESYNC */
 #if TURNOFF_AT_SLOT_END
   off();
 #endif
   t_txrx_end = DCO_NOW();
+  CHAOS_PROBE_END_AT(wait, CHAOS_PROBE_RADIO_WAIT, call_dco_delay);
+  CHAOS_PROBE_ADD(CHAOS_PROBE_RADIO_RX, t_txrx_end - call_dco);
+  ENERGY_RADIO_ON(call_dco_delay);
   t_go_actual = RTIMER_DCO_TO_VHT(wait_end_rtimer, call_dco-wait_end_dco);
   t_sfd_goal_log = t_sfd_goal;
 
   return status;
 }
 
+#if CHAOS_SLOT_OVERRUN_DETECTION
+/* have we already passed the latest time to enter chaos_do_tx/rx for the next slot? */
+static inline int
+chaos_slot_overrun(chaos_state_t state){
+  vht_clock_t go_goal = (state == CHAOS_TX) ? t_sfd_goal - CHAOS_TX_DELAY_VHT
+      : t_sfd_goal - RTIMER_TO_VHT(RX_GUARD_TIME / 2) - CHAOS_RX_DELAY_VHT;
+  rtimer_clock_t deadline = VHT_TO_RTIMER(go_goal) - CHAOS_SLOT_OVERRUN_GUARD
+      - ((state == CHAOS_TX) ? CHAOS_TX_RTIMER_GUARD : CHAOS_RX_RTIMER_GUARD);
+  return !RTIMER_LT(RTIMER_NOW(), deadline);
+}
+#endif /* CHAOS_SLOT_OVERRUN_DETECTION */
+
+static uint16_t chaos_round_slots = 0;
+
+uint16_t
+chaos_get_round_slots(void){
+  return chaos_round_slots;
+}
+
+uint16_t
+chaos_get_slot_overruns(uint8_t app_id){
+#if CHAOS_SLOT_OVERRUN_DETECTION
+  return app_id < CHAOS_MAX_APPS ? chaos_slot_overruns[app_id] : 0;
+#else
+  return 0;
+#endif /* CHAOS_SLOT_OVERRUN_DETECTION */
+}
+
+const chaos_energy_t*
+chaos_get_energy_round(void)
+{
+#if CHAOS_ENERGY_ACCOUNTING
+  return &chaos_energy_round;
+#else
+  return NULL;
+#endif /* CHAOS_ENERGY_ACCOUNTING */
+}
+
+const chaos_energy_t*
+chaos_get_energy_app(uint8_t app_id)
+{
+#if CHAOS_ENERGY_ACCOUNTING
+  return app_id < CHAOS_MAX_APPS ? &chaos_energy_app[app_id] : NULL;
+#else
+  return NULL;
+#endif /* CHAOS_ENERGY_ACCOUNTING */
+}
+
 uint16_t
 chaos_round(const uint16_t round_number, const uint8_t app_id, const uint8_t* const payload, const uint8_t payload_length_app, const rtimer_clock_t slot_length_app_dco,
     const uint16_t max_slots,  const uint8_t app_flags_len, process_callback_t process){
@@ -498,7 +709,7 @@ chaos_round(const uint16_t round_number, const uint8_t app_id, const uint8_t* co
 
   //init
   // XXX if not initiator, payload_length_app is usually 0!!
-  vht_clock_t slot_length_app = RTIMER_TO_VHT(chaos_apps[app_id]->slot_length);
+  vht_clock_t slot_length_app = RTIMER_TO_VHT(CHAOS_SLOT_LENGTH(app_id));
   uint8_t payload_length = MIN(CHAOS_MAX_PAYLOAD_LEN, payload_length_app);
   static uint16_t slot_number;
   static uint16_t sync_slot;
@@ -513,7 +724,20 @@ chaos_round(const uint16_t round_number, const uint8_t app_id, const uint8_t* co
   memset(chaos_slot_stats, 0, sizeof(chaos_slot_stats));
   memset(chaos_slot_timing_log_max, 0, sizeof(chaos_slot_timing_log_max));
   memset(chaos_slot_timing_log_min, 0xff, sizeof(chaos_slot_timing_log_min));
-
+#if CHAOS_ENERGY_ACCOUNTING
+  memset(&chaos_energy_round, 0, sizeof(chaos_energy_round));
+#endif /* CHAOS_ENERGY_ACCOUNTING */
+
+#if CHAOS_CO_INITIATORS
+  /* co-initiate only if the network synced us in the last round */
+  uint8_t co_initiator_ready = IS_CO_INITIATOR() && round_synced && co_initiator_heard;
+  co_initiator_active = 0;
+  co_initiator_resync = 0;
+  co_initiator_heard = 0;
+#endif /* CHAOS_CO_INITIATORS */
+#if CHAOS_HEADER_COMPRESSION
+  tx_compact = 0;
+#endif /* CHAOS_HEADER_COMPRESSION */
   //TODO OL: for each packet we received: check if it matches this number, otherwise: cancel this round? and resync?
   tx_header->round_number = round_number;
   //TODO OL: init more: check header struct..
@@ -521,7 +745,7 @@ chaos_round(const uint16_t round_number, const uint8_t app_id, const uint8_t* co
   tx_header->chaos_fcf_1 = CHAOS_FCF_1;
   tx_header->dst_pan_id = CHAOS_PANID;
   tx_header->initiator_id = INITIATOR_NODE_ID;
-  tx_header->chaos_node_count = chaos_node_count;
+  CHAOS_HEADER_SET_NODE_COUNT(tx_header, chaos_node_count);
 #if CHAOS_USE_DST_ID
   tx_header->dst_node_id = FRAME802154_BROADCASTADDR;
 #endif
@@ -529,7 +753,7 @@ chaos_round(const uint16_t round_number, const uint8_t app_id, const uint8_t* co
   tx_header->src_node_id = CHAOS_USE_SRC_ID==2 ? INITIATOR_NODE_ID : node_id;
 #endif
   //TODO OL: check that each received packet matches app_id, round_number, ... -> if not: cancel this round and resync.
-  tx_header->id = app_id;
+  CHAOS_HEADER_SET_APP_ID(tx_header, app_id);
 #if CHAOS_HW_SECURITY
   tx_header->security_control = CHAOS_SECURITY_CONTROL;
 #endif /* CHAOS_HW_SECURITY */
@@ -541,31 +765,57 @@ chaos_round(const uint16_t round_number, const uint8_t app_id, const uint8_t* co
   }
 
   if(IS_INITIATOR()) {
-    next_round_id = tx_header->next_round_id = scheduler_get_next_round_app_id();
-    next_round_begin = tx_header->next_round_start = scheduler_get_next_round_begin();
+    next_round_id = scheduler_get_next_round_app_id();
+    CHAOS_HEADER_SET_NEXT_ROUND_ID(tx_header, next_round_id);
+    tx_header->next_round_start = CHAOS_INTERVAL_ENCODE(scheduler_get_next_round_begin());
+    next_round_begin = CHAOS_INTERVAL_DECODE(tx_header->next_round_start);
+    chaos_rank = 0;
+    chaos_time_rank = 0;
+    round_synced = 1;
+    sync_slot = 0;
+#if CHAOS_CO_INITIATORS
+    /* keep our schedule in next_round_*, it goes into the header after the first tx */
+    co_initiator_set_default_schedule(app_id);
+  } else if(co_initiator_ready) {
+    /* we were synced by the network in the last round: start this round at the predicted time.
+     * Announce the current schedule as the default for the next round, the initiator's schedule overrides it */
+    co_initiator_active = 1;
+    co_initiator_resync = 1;
+    co_initiator_set_default_schedule(app_id);
+    next_round_id = CHAOS_HEADER_GET_NEXT_ROUND_ID(tx_header);
+    next_round_begin = CHAOS_INTERVAL_DECODE(tx_header->next_round_start);
     chaos_rank = 0;
     chaos_time_rank = 0;
     round_synced = 1;
     sync_slot = 0;
+#endif /* CHAOS_CO_INITIATORS */
   } else {
     round_synced = 0;
     sync_slot = 0xffff;
     //chaos_rank = CHAOS_MAX_RANK;
     //chaos_time_rank = CHAOS_MAX_RANK;
   }
+#if CHAOS_FAST_RESYNC
+  /* widen only the round-start listen, at most by one slot */
+  round_start_guard = round_synced ? 0 : MIN(CHAOS_ROUND_GUARD_TIME, CHAOS_SLOT_LENGTH(app_id));
+#endif /* CHAOS_FAST_RESYNC */
 #if CHAOS_USE_SRC_RANK
   tx_header->src_rank = chaos_rank;
 //  tx_header->src_time_rank = chaos_time_rank;
 #endif
   chaos_multichannel_round_init(IS_INITIATOR(), tx_header);
+  chaos_slot_calibration_round_init(IS_INITIATOR(), app_id, tx_header);
 
-  memcpy(tx_header->payload, payload, payload_length);
+  /* sub-payloads of the riders go first, the app payload follows */
+  const uint8_t piggyback_length = chaos_piggyback_round_init(round_number, app_id, payload_length, tx_header->payload);
+  memcpy(tx_header->payload + piggyback_length, payload, payload_length);
+  payload_length += piggyback_length;
   tx_header->length = CHAOS_PAYLOAD_LEN_TO_PACKET_LENGTH(payload_length);
 
   chaos_state_t chaos_state = CHAOS_INIT;
   if( NETSTACK_CONF_WITH_CHAOS_NODE_DYNAMIC || !chaos_apps[app_id]->requires_node_index || (chaos_apps[app_id]->requires_node_index && chaos_has_node_index )){
     //LEDS_TOGGLE(LEDS_BLUE);
-    chaos_state = process(0, 0, chaos_state, 0, CHAOS_PAYLOAD_LENGTH(tx_header), rx_header->payload, tx_header->payload, &app_flags);
+    chaos_state = process(0, 0, chaos_state, 0, CHAOS_PAYLOAD_LENGTH(tx_header) - piggyback_length, rx_header->payload + piggyback_length, tx_header->payload + piggyback_length, &app_flags);
   } else {
     CHAOS_LOG_ADD_MSG("! hasIdx %u id %u", chaos_has_node_index, node_id);
   }
@@ -609,14 +859,39 @@ chaos_round(const uint16_t round_number, const uint8_t app_id, const uint8_t* co
     //for long rounds, pet the watchdog every slot to keep it calm :)
     watchdog_periodic();
 
+#if CHAOS_SLOT_OVERRUN_DETECTION
+    if(slot_number > sync_slot && chaos_slot_overrun(chaos_state)){
+      /* too late for this slot: a late tx would break the capture effect, so skip it
+       * and keep the app state as it is. The skipped slot leaves time to catch up.
+       * Every slot log value is an rx/tx status: the skipped slot stays unlogged */
+      chaos_slot_overruns[app_id]++;
+#if CHAOS_HEADER_COMPRESSION
+      tx_compact = 0;
+#endif /* CHAOS_HEADER_COMPRESSION */
+      t_sfd_goal += slot_length_app;
+      slot_number++;
+      HOP_CHANNEL(round_number, slot_number);
+      LEDS_OFF(LEDS_BLUE);
+      continue;
+    }
+#endif /* CHAOS_SLOT_OVERRUN_DETECTION */
+
     if(chaos_state == CHAOS_TX){
-      tx_header->slot_number = slot_number;
-      tx_header->slot_number_msb = slot_number > 255;
+      CHAOS_HEADER_SET_SLOT_NUMBER(tx_header, slot_number);
       tx_header->round_number = round_number;
 #if CHAOS_USE_SRC_RANK
       tx_header->src_rank = chaos_rank;
       //tx_header->src_time_rank = chaos_time_rank;
 #endif
+#if CHAOS_HEADER_COMPRESSION
+      if(tx_compact) {
+        CHAOS_HEADER_SET_SLOT_NUMBER(tx_compact_header, slot_number);
+        tx_compact_header->round_number = round_number;
+#if CHAOS_USE_SRC_RANK
+        tx_compact_header->src_rank = chaos_rank;
+#endif
+      }
+#endif /* CHAOS_HEADER_COMPRESSION */
 #if CHAOS_HW_SECURITY
       //tx_header->src_node_id = node_id;
 //        tx_header->chaos_security_frame_counter.round_number = round_number;
@@ -631,15 +906,22 @@ chaos_round(const uint16_t round_number, const uint8_t app_id, const uint8_t* co
 #endif /* CHAOS_HW_SECURITY */
 
         chaos_slot_status = chaos_do_tx();
+#if CHAOS_CO_INITIATORS
+        if(IS_INITIATOR() && !tx_header->schedule_from_initiator){
+          /* the slot-0 frame matched the co-initiators' ones, from now on announce our schedule */
+          CHAOS_HEADER_SET_NEXT_ROUND_ID(tx_header, next_round_id);
+          tx_header->next_round_start = CHAOS_INTERVAL_ENCODE(next_round_begin);
+          tx_header->schedule_from_initiator = 1;
+        }
+#endif /* CHAOS_CO_INITIATORS */
 
         chaos_slot_timing_log_current[TX] = t_txrx_end - call_dco;
         chaos_slot_timing_tx_sum += chaos_slot_timing_log_current[TX];
+        ENERGY_ADD(radio_tx, t_txrx_end - t_radio_on_dco);
         if(slot_number > sync_slot){ //ignore first slot
           chaos_slot_timing_log_current[TX_PREPARE] = call_dco - t_slot_start_dco;
-          chaos_slot_timing_log_max[TX_PREPARE] = MAX(chaos_slot_timing_log_current[TX_PREPARE], chaos_slot_timing_log_max[TX_PREPARE]);
-          chaos_slot_timing_log_min[TX_PREPARE] = MIN(chaos_slot_timing_log_current[TX_PREPARE], chaos_slot_timing_log_min[TX_PREPARE]);
-          chaos_slot_timing_log_max[TX] = MAX(chaos_slot_timing_log_current[TX], chaos_slot_timing_log_max[TX]);
-          chaos_slot_timing_log_min[TX] = MIN(chaos_slot_timing_log_current[TX], chaos_slot_timing_log_min[TX]);
+          SLOT_TIMING_LOG(TX_PREPARE);
+          SLOT_TIMING_LOG(TX);
         }
 
 //      COOJA_DEBUG_STRX("delay_exact_dco", delay_exact_dco, 6);
@@ -658,21 +940,36 @@ chaos_round(const uint16_t round_number, const uint8_t app_id, const uint8_t* co
       chaos_slot_status = chaos_do_rx(app_id);
       chaos_slot_timing_log_current[RX] = t_txrx_end - call_dco;
       chaos_slot_timing_rx_sum += chaos_slot_timing_log_current[RX];
+#if CHAOS_ENERGY_ACCOUNTING
+      {
+        /* the frame itself is received, the rest of the time the radio listens */
+        rtimer_clock_t t_radio = t_txrx_end - t_radio_on_dco;
+        rtimer_clock_t t_frame = (chaos_slot_status == CHAOS_TXRX_OK)
+            ? MIN(CHAOS_PACKET_DURATION_DCO(CHAOS_PACKET_RADIO_LENGTH(rx_header->length)), t_radio) : 0;
+        ENERGY_ADD(radio_rx, t_frame);
+        ENERGY_ADD(radio_listen, t_radio - t_frame);
+      }
+#endif /* CHAOS_ENERGY_ACCOUNTING */
       if(slot_number > sync_slot){
         chaos_slot_timing_log_current[RX_PREPARE] = call_dco - t_slot_start_dco;
-        chaos_slot_timing_log_max[RX_PREPARE] = MAX(chaos_slot_timing_log_current[RX_PREPARE], chaos_slot_timing_log_max[RX_PREPARE]);
-        chaos_slot_timing_log_min[RX_PREPARE] = MIN(chaos_slot_timing_log_current[RX_PREPARE], chaos_slot_timing_log_min[RX_PREPARE]);
-        chaos_slot_timing_log_max[RX] = MAX(chaos_slot_timing_log_current[RX], chaos_slot_timing_log_max[RX]);
-        chaos_slot_timing_log_min[RX] = MIN(chaos_slot_timing_log_current[RX], chaos_slot_timing_log_min[RX]);
+        SLOT_TIMING_LOG(RX_PREPARE);
+        SLOT_TIMING_LOG(RX);
       }
 
       /* it could be a valid packet but an unexpected app id.
        * Shall we use it for synchronization anyway?
        * Now we don't */
 
-      chaos_slot_status = chaos_post_rx(chaos_slot_status, app_id, round_synced, round_number);
+      CHAOS_PROBE(CHAOS_PROBE_POST_RX, chaos_slot_status = chaos_post_rx(chaos_slot_status, app_id, round_synced, round_number));
+      if(round_synced){
+        chaos_termination_rx_slot(chaos_slot_status == CHAOS_TXRX_OK);
+      }
 
       if(chaos_slot_status == CHAOS_TXRX_OK){
+        chaos_slot_calibration_rx(app_id, rx_header);
+#if CHAOS_CO_INITIATORS
+        co_initiator_heard = 1;
+#endif /* CHAOS_CO_INITIATORS */
         //slot_number = rx_header->slot_number;
         //slot_number |= rx_header->slot_number_msb ? 0x100 : 0;
 
@@ -707,24 +1004,36 @@ chaos_round(const uint16_t round_number, const uint8_t app_id, const uint8_t* co
             }
           }
           if( !round_synced ){
-            slot_number = rx_header->slot_number;
-            slot_number |= rx_header->slot_number_msb ? 0x100 : 0;
+            slot_number = CHAOS_HEADER_GET_SLOT_NUMBER(rx_header);
+            /* the initiator may have announced a new slot length */
+            slot_length_app = RTIMER_TO_VHT(CHAOS_SLOT_LENGTH(app_id));
             round_rtimer = ROUND_START_FROM_SLOT(t_sfd_actual, slot_number, slot_length_app);
             t_sfd_goal = t_sfd_actual;
             round_synced = 1;
             sync_slot = slot_number;
-            next_round_begin = rx_header->next_round_start;
-            next_round_id = rx_header->next_round_id;
+            next_round_begin = CHAOS_INTERVAL_DECODE(rx_header->next_round_start);
+            next_round_id = CHAOS_HEADER_GET_NEXT_ROUND_ID(rx_header);
   //          CHAOS_LOG_ADD_MSG("!rr %u, f %u, %u %ul\n", round_rtimer, t_sfd_actual_rtimer, slot_number, slot_length_app);
           }
+#if CHAOS_CO_INITIATORS
+          else if( co_initiator_resync ){
+            /* co-initiator: follow the timing of the network rather than our own prediction,
+             * so that the co-initiators do not drift away from the initiator over rounds */
+            if( ABS_VHT(t_sfd_goal - t_sfd_actual) < RTIMER_TO_VHT(CHAOS_ROUND_GUARD_TIME) ){
+              round_rtimer = ROUND_START_FROM_SLOT(t_sfd_actual, slot_number, slot_length_app);
+              t_sfd_goal = t_sfd_actual;
+            }
+            co_initiator_resync = 0;
+          }
+#endif /* CHAOS_CO_INITIATORS */
         }
       } else {
         chaos_rank += ( !IS_INITIATOR() ) ? CHAOS_RANK_IDLE_INCREMENT : 0;
 
         if( chaos_slot_status == CHAOS_TXRX_OK_FOREIGN_CLUSTER){
           #if NETSTACK_CONF_WITH_CHAOS_LEADER_ELECTION
-          uint8_t new_better_than_mine = compare_leaders_raw(rx_header->initiator_id, rx_header->chaos_node_count, INITIATOR_NODE_ID, chaos_node_count);
-          uint8_t new_better_than_sniffed = compare_leaders_raw(rx_header->initiator_id, rx_header->chaos_node_count, sniffed_leader.initiator_id, sniffed_leader.chaos_node_count);
+          uint8_t new_better_than_mine = compare_leaders_raw(rx_header->initiator_id, CHAOS_HEADER_GET_NODE_COUNT(rx_header), INITIATOR_NODE_ID, chaos_node_count);
+          uint8_t new_better_than_sniffed = compare_leaders_raw(rx_header->initiator_id, CHAOS_HEADER_GET_NODE_COUNT(rx_header), sniffed_leader.initiator_id, sniffed_leader.chaos_node_count);
           if(new_better_than_mine && new_better_than_sniffed){
             extract_leader(&sniffed_leader, rx_header, t_sfd_actual);
           }
@@ -753,20 +1062,21 @@ chaos_round(const uint16_t round_number, const uint8_t app_id, const uint8_t* co
     rtimer_clock_t t_post_txrx_end = DCO_NOW();
     if(slot_number > sync_slot){
       chaos_slot_timing_log_current[timing_log_state] = t_post_txrx_end - t_txrx_end;
-      chaos_slot_timing_log_max[timing_log_state] = MAX(chaos_slot_timing_log_current[timing_log_state], chaos_slot_timing_log_max[timing_log_state]);
-      chaos_slot_timing_log_min[timing_log_state] = MIN(chaos_slot_timing_log_current[timing_log_state], chaos_slot_timing_log_min[RX]);
+      SLOT_TIMING_LOG(timing_log_state);
     }
     /* process app */
+#if CHAOS_PIGGYBACK
+    chaos_state_t slot_state = chaos_state;
+#endif /* CHAOS_PIGGYBACK */
     if( //XXX does not work because we need to process after tx too (rx_header->initiator_id == INITIATOR_NODE_ID || INITIATOR_NODE_ID == 0) &&
         (!chaos_apps[app_id]->requires_node_index || chaos_has_node_index) ){
-      chaos_state = process(round_number, slot_number, chaos_state, (chaos_slot_status == CHAOS_TXRX_OK), (chaos_slot_status == CHAOS_TXRX_OK) ? CHAOS_PAYLOAD_LENGTH(rx_header) : 0, rx_header->payload, tx_header->payload, &app_flags);
+      CHAOS_PROBE(CHAOS_PROBE_PROCESS, chaos_state = process(round_number, slot_number, chaos_state, (chaos_slot_status == CHAOS_TXRX_OK), (chaos_slot_status == CHAOS_TXRX_OK) ? CHAOS_PAYLOAD_LENGTH(rx_header) - piggyback_length : 0, rx_header->payload + piggyback_length, tx_header->payload + piggyback_length, &app_flags));
       int app_do_sync = ( chaos_state == CHAOS_RX_SYNC ) || ( chaos_state == CHAOS_TX_SYNC );
       chaos_state = ( chaos_state == CHAOS_RX_SYNC ) ? chaos_state = CHAOS_RX : (( chaos_state == CHAOS_TX_SYNC ) ? chaos_state = CHAOS_TX : chaos_state);
       if( chaos_slot_status == CHAOS_TXRX_OK && app_do_sync  && CHAOS_ENABLE_SFD_SYNC == 2){
         /* the application reports a packet coming from the initiator, so we can synchronize on it;
          * e.g., we got a phase transition that only the initiator can issue */
-        slot_number = rx_header->slot_number;
-        slot_number |= rx_header->slot_number_msb ? 0x100 : 0;
+        slot_number = CHAOS_HEADER_GET_SLOT_NUMBER(rx_header);
         round_rtimer = ROUND_START_FROM_SLOT(t_sfd_actual, slot_number, slot_length_app);
         t_sfd_goal = t_sfd_actual;
       }
@@ -789,6 +1099,12 @@ chaos_round(const uint16_t round_number, const uint8_t app_id, const uint8_t* co
       chaos_state = CHAOS_RX;
     }
 #endif /* NETSTACK_CONF_WITH_CHAOS_NODE_DYNAMIC */
+#if CHAOS_PIGGYBACK
+    if(chaos_state != CHAOS_OFF) {
+      chaos_state = chaos_piggyback_process(round_number, slot_number, slot_state, chaos_state,
+          (chaos_slot_status == CHAOS_TXRX_OK), rx_header->payload, tx_header->payload);
+    }
+#endif /* CHAOS_PIGGYBACK */
 
     t_sfd_goal += slot_length_app;
 
@@ -798,12 +1114,10 @@ chaos_round(const uint16_t round_number, const uint8_t app_id, const uint8_t* co
     if(slot_number > sync_slot){
       if((!chaos_apps[app_id]->requires_node_index || chaos_has_node_index) && !is_join_app){
         chaos_slot_timing_log_current[APP_PROCESSING] = t_app_processing_end - t_post_txrx_end;
-        chaos_slot_timing_log_max[APP_PROCESSING] = MAX(chaos_slot_timing_log_current[APP_PROCESSING], chaos_slot_timing_log_max[APP_PROCESSING]);
-        chaos_slot_timing_log_min[APP_PROCESSING] = MIN(chaos_slot_timing_log_current[APP_PROCESSING], chaos_slot_timing_log_min[APP_PROCESSING]);
+        SLOT_TIMING_LOG(APP_PROCESSING);
       } else if(is_join_app){
         chaos_slot_timing_log_current[JOIN_PROCESSING] = t_app_processing_end - t_post_txrx_end;
-        chaos_slot_timing_log_max[JOIN_PROCESSING] = MAX(chaos_slot_timing_log_current[JOIN_PROCESSING], chaos_slot_timing_log_max[JOIN_PROCESSING]);
-        chaos_slot_timing_log_min[JOIN_PROCESSING] = MIN(chaos_slot_timing_log_current[JOIN_PROCESSING], chaos_slot_timing_log_min[JOIN_PROCESSING]);
+        SLOT_TIMING_LOG(JOIN_PROCESSING);
       }
     }
     /* log */
@@ -837,14 +1151,10 @@ chaos_round(const uint16_t round_number, const uint8_t app_id, const uint8_t* co
         log->txrx.src_node_id = (chaos_state_backup_log == CHAOS_RX ) ? rx_header->src_node_id : tx_header->src_node_id;
 #endif
 #if CHAOS_LOG_FLAGS
-        if(!round_synced || !app_flags || !app_flags_len ) {
-          memset(log->txrx.app_flags, 0, LOG_APP_FLAGS_LEN);
-        } else {
-          memcpy(log->txrx.app_flags, app_flags, MIN(app_flags_len, LOG_APP_FLAGS_LEN));
-        }
+        chaos_log_set_flags(log, round_synced ? app_flags : NULL, app_flags_len);
 #endif /* CHAOS_LOG_FLAGS */
 #if NETSTACK_CONF_WITH_CHAOS_NODE_DYNAMIC
-        void* payload = ( chaos_state_backup_log == CHAOS_RX ) ? rx_header->payload : tx_header->payload;
+        void* payload = (( chaos_state_backup_log == CHAOS_RX ) ? rx_header->payload : tx_header->payload) + piggyback_length;
         log->txrx.join_committed = join_is_committed_from_payload( payload );
         log->txrx.join_has_node_index = chaos_has_node_index;
         log->txrx.join_slot_count = join_get_slot_count_from_payload( payload );
@@ -866,17 +1176,42 @@ chaos_round(const uint16_t round_number, const uint8_t app_id, const uint8_t* co
     HOP_CHANNEL(round_number, slot_number);
     LEDS_OFF(LEDS_BLUE);
 
+#if CHAOS_SLOT_CALIBRATION
+    /* failed receptions last until the rx timeout, which depends on the slot length itself */
+    if(slot_number > sync_slot + 1 && (timing_log_state == TX_POST || chaos_slot_status == CHAOS_TXRX_OK)) {
+      chaos_slot_calibration_add_slot(DCO_NOW() - t_slot_start_dco);
+    }
+#endif /* CHAOS_SLOT_CALIBRATION */
+
+#if CHAOS_HEADER_COMPRESSION
+    /* prepare the compact frame in the idle time of this slot */
+    tx_compact = chaos_state == CHAOS_TX && CHAOS_HEADER_COMPACT_SLOT(slot_number);
+    if(tx_compact) {
+      chaos_header_compress();
+    }
+#endif /* CHAOS_HEADER_COMPRESSION */
+
+    /* the wait for the slot end is not processing */
+    ENERGY_ADD(cpu, DCO_NOW() - t_slot_start_dco);
 #if BUSYWAIT_UNTIL_SLOT_END
     //t_last_slot = VHT_NOW() - t_slot_start;
     /* busy wait until end of slot if we still have time */
     rtimer_clock_t sfd_goal_rtimer = VHT_TO_RTIMER(t_sfd_goal);
-    rtimer_clock_t slot_guard_time = ((round_synced ? RX_GUARD_TIME/2 : ROUND_GUARD_TIME/2))
+    rtimer_clock_t slot_guard_time = ((round_synced ? RX_GUARD_TIME/2 : CHAOS_DRIFT_ROUND_GUARD_TIME/2))
         + (2) + VHT_TO_RTIMER(PREP_RX_VHT + 2*RX_LEDS_DELAY) /* for led toggling */
         + ( (chaos_state == CHAOS_RX) ? VHT_TO_RTIMER(CHAOS_RX_DELAY_VHT)
                                       : VHT_TO_RTIMER(CHAOS_TX_DELAY_VHT) );
-
-    rtimer_clock_t slot_start = sfd_goal_rtimer - chaos_apps[app_id]->slot_length;
-    rtimer_clock_t timeout = chaos_apps[app_id]->slot_length - slot_guard_time;
+    /* never wait past the slot: the timeout below must not underflow */
+    slot_guard_time = MIN(slot_guard_time, CHAOS_SLOT_LENGTH(app_id) - RTIMER_MIN_DELAY);
+
+    rtimer_clock_t slot_start = sfd_goal_rtimer - CHAOS_SLOT_LENGTH(app_id);
+    rtimer_clock_t timeout = CHAOS_SLOT_LENGTH(app_id) - slot_guard_time;
+#if CHAOS_LPM_BETWEEN_SLOTS
+    /* sleep through the idle part and busy wait only for the last ticks */
+    if(!chaos_schedule_check_timer_miss(slot_start, timeout - CHAOS_LPM_WAKEUP_GUARD, RTIMER_NOW())) {
+      chaos_platform_lpm_wait_until(slot_start + timeout - RTIMER_MIN_DELAY - CHAOS_LPM_WAKEUP_GUARD);
+    }
+#endif /* CHAOS_LPM_BETWEEN_SLOTS */
     while(!chaos_schedule_check_timer_miss(slot_start, timeout, RTIMER_NOW()));
 
 #endif /* BUSYWAIT_UNTIL_SLOT_END */
@@ -885,11 +1220,9 @@ chaos_round(const uint16_t round_number, const uint8_t app_id, const uint8_t* co
     rtimer_clock_t t_slot_end = DCO_NOW();
     if(slot_number > sync_slot + 1){
       chaos_slot_timing_log_current[SLOT_END_PROCCESSING] = t_slot_end - t_app_processing_end;
-      chaos_slot_timing_log_max[SLOT_END_PROCCESSING] = MAX(chaos_slot_timing_log_current[SLOT_END_PROCCESSING], chaos_slot_timing_log_max[SLOT_END_PROCCESSING]);
-      chaos_slot_timing_log_min[SLOT_END_PROCCESSING] = MIN(chaos_slot_timing_log_current[SLOT_END_PROCCESSING], chaos_slot_timing_log_min[SLOT_END_PROCCESSING]);
+      SLOT_TIMING_LOG(SLOT_END_PROCCESSING);
       chaos_slot_timing_log_current[SLOT_TIME_ALL] = t_slot_end - t_slot_start_dco;
-      chaos_slot_timing_log_max[SLOT_TIME_ALL] = MAX(chaos_slot_timing_log_current[SLOT_TIME_ALL], chaos_slot_timing_log_max[SLOT_TIME_ALL]);
-      chaos_slot_timing_log_min[SLOT_TIME_ALL] = MIN(chaos_slot_timing_log_current[SLOT_TIME_ALL], chaos_slot_timing_log_min[SLOT_TIME_ALL]);
+      SLOT_TIMING_LOG(SLOT_TIME_ALL);
       if(chaos_slot_timing_log_current[SLOT_TIME_ALL] >= chaos_slot_timing_log_min[SLOT_TIME_ALL]){
         chaos_slot_timing_log_min[SLOTNUMBER] = slot_number;
       }
@@ -901,6 +1234,19 @@ chaos_round(const uint16_t round_number, const uint8_t app_id, const uint8_t* co
 
   LEDS_OFF(LEDS_RED);
   off();
+#if CHAOS_ENERGY_ACCOUNTING
+  if(app_id < CHAOS_MAX_APPS) {
+    chaos_energy_app[app_id].radio_tx += DCO_TO_US(chaos_energy_round.radio_tx);
+    chaos_energy_app[app_id].radio_listen += DCO_TO_US(chaos_energy_round.radio_listen);
+    chaos_energy_app[app_id].radio_rx += DCO_TO_US(chaos_energy_round.radio_rx);
+    chaos_energy_app[app_id].cpu += DCO_TO_US(chaos_energy_round.cpu);
+  }
+#endif /* CHAOS_ENERGY_ACCOUNTING */
+  chaos_slot_calibration_round_end(IS_INITIATOR(), app_id);
+  chaos_piggyback_round_end(round_number, tx_header->payload);
+#if CHAOS_SLOT_CALIBRATION
+  CHAOS_LOG_ADD_MSG("{I}SL a%u l%u b%u", app_id, CHAOS_SLOT_LENGTH(app_id), chaos_slot_calibration_get_round_busy_max());
+#endif /* CHAOS_SLOT_CALIBRATION */
   for(i = 0; i < chaos_app_count; i++){
     if( chaos_apps[i]->round_end_sniffer != NULL ){
       chaos_apps[i]->round_end_sniffer(tx_header);
@@ -914,12 +1260,13 @@ chaos_round(const uint16_t round_number, const uint8_t app_id, const uint8_t* co
   watchdog_periodic();
 
   //TODO: write result to payload packet
+  chaos_round_slots = slot_number;
   return slot_number;
 }
 
 #if NETSTACK_CONF_WITH_CHAOS_LEADER_ELECTION
 
-uint8_t compare_leaders_raw(uint16_t id1, uint8_t node_count1, uint16_t id2, uint8_t node_count2){
+uint8_t compare_leaders_raw(uint16_t id1, chaos_node_index_t node_count1, uint16_t id2, chaos_node_index_t node_count2){
   return (node_count1 > node_count2 && id1 != 0)
       || (node_count1 == node_count2 && id1 < id2 && id1 != 0); //tie breaker
 }
@@ -934,25 +1281,24 @@ uint8_t extract_leader(chaos_leader_t* rx_leader, chaos_header_t* rx_header, vht
   rtimer_clock_t next_round;
   uint16_t slot_number;
   const chaos_app_t* app =  NULL;
-  if(rx_header->id < chaos_app_count){
-    app = chaos_apps[rx_header->id];
+  if(CHAOS_HEADER_GET_APP_ID(rx_header) < chaos_app_count){
+    app = chaos_apps[CHAOS_HEADER_GET_APP_ID(rx_header)];
   } else { //app is not configured --> Can't know slot_length --> Won't work
     return 0;
   }
 
-  rx_leader->chaos_node_count = rx_header->chaos_node_count;
+  rx_leader->chaos_node_count = CHAOS_HEADER_GET_NODE_COUNT(rx_header);
   rx_leader->initiator_id = rx_header->initiator_id;
-  slot_number = rx_header->slot_number;
-  slot_number |= rx_header->slot_number_msb ? 0x100 : 0;
+  slot_number = CHAOS_HEADER_GET_SLOT_NUMBER(rx_header);
 
-  vht_clock_t slot_length = RTIMER_TO_VHT(app->slot_length);
-  rx_round_rtimer_vht = ROUND_START_FROM_SLOT(sfd_vht, rx_header->slot_number, slot_length);
+  vht_clock_t slot_length = RTIMER_TO_VHT(CHAOS_HEADER_SLOT_LENGTH(rx_header, app));
+  rx_round_rtimer_vht = ROUND_START_FROM_SLOT(sfd_vht, slot_number, slot_length);
 //  rx_round_rtimer = VHT_TO_RTIMER(rx_round_rtimer_vht - get_round_rtimer());
 //  rx_leader->next_round_start = rx_round_rtimer + rx_header->next_round_start;
   //rx_round_rtimer = VHT_TO_RTIMER(rx_round_rtimer_vht);
-  rx_leader->round_rtimer = (rx_round_rtimer_vht - get_round_rtimer() - RTIMER_TO_VHT(rx_header->next_round_start));
+  rx_leader->round_rtimer = (rx_round_rtimer_vht - get_round_rtimer() - RTIMER_TO_VHT(CHAOS_INTERVAL_DECODE(rx_header->next_round_start)));
   rx_leader->next_round_start = rx_header->next_round_start;
-  rx_leader->next_round_id = rx_header->next_round_id;
+  rx_leader->next_round_id = CHAOS_HEADER_GET_NEXT_ROUND_ID(rx_header);
   rx_leader->round_number = rx_header->round_number;
   printf("leader time %d %lu - %lu = %lu\n", rx_leader->initiator_id, rx_round_rtimer_vht, round_rtimer, rx_leader->round_rtimer);
   return 1;
@@ -962,7 +1308,7 @@ void chaos_update_leader(chaos_leader_t* new_leader){
   chaos_node_count = new_leader->chaos_node_count;
   initiator_node_id = new_leader->initiator_id;
   next_round_id = new_leader->next_round_id;
-  next_round_begin = new_leader->next_round_start;
+  next_round_begin = CHAOS_INTERVAL_DECODE(new_leader->next_round_start);
   int round_number_offset = 0;
 //  rtimer_clock_t rt = VHT_TO_RTIMER(round_rtimer + new_leader->round_rtimer);
 //  if(chaos_schedule_check_timer_miss(rt, next_round_begin, RTIMER_NOW())){
@@ -1017,17 +1363,17 @@ uint8_t chaos_sniff_leader(timer_t* end_time){
     } while(rx_status != CHAOS_TXRX_OK && !chaos_schedule_check_timer_miss(end_time->ref, end_time->offset, RTIMER_NOW())); //XXX
     if(rx_status == CHAOS_TXRX_OK){
       //what if we hear the same leader with less nodes??
-      uint8_t new_better_than_mine = compare_leaders_raw(rx_header->initiator_id, rx_header->chaos_node_count, INITIATOR_NODE_ID, chaos_node_count);
-      uint8_t new_better_than_sniffed = compare_leaders_raw(rx_header->initiator_id, rx_header->chaos_node_count, sniffed_leader.initiator_id, sniffed_leader.chaos_node_count);
+      uint8_t new_better_than_mine = compare_leaders_raw(rx_header->initiator_id, CHAOS_HEADER_GET_NODE_COUNT(rx_header), INITIATOR_NODE_ID, chaos_node_count);
+      uint8_t new_better_than_sniffed = compare_leaders_raw(rx_header->initiator_id, CHAOS_HEADER_GET_NODE_COUNT(rx_header), sniffed_leader.initiator_id, sniffed_leader.chaos_node_count);
       if(new_better_than_mine && new_better_than_sniffed){
         extract_leader(&sniffed_leader, rx_header, sfd_vht);
         found_new_leader = 1;
       }
       printf("{rd-%u st-%u ch-%u} rx %u @ %u, sniffed %u @ %u, mine %u @ %u\n",
           rx_header->round_number,
-          rx_header->slot_number + (rx_header->slot_number_msb ? 0x100 : 0),
+          CHAOS_HEADER_GET_SLOT_NUMBER(rx_header),
           chaos_multichannel_get_current_channel(),
-          rx_header->initiator_id, rx_header->chaos_node_count,
+          rx_header->initiator_id, CHAOS_HEADER_GET_NODE_COUNT(rx_header),
           sniffed_leader.initiator_id, sniffed_leader.chaos_node_count,
           INITIATOR_NODE_ID, chaos_node_count);
     } else {
@@ -1046,7 +1392,7 @@ uint8_t chaos_boot_election(rtimer_clock_t* t_sfd_actual_rtimer_ptr, uint16_t *r
   volatile uint8_t rx_status = CHAOS_TXRX_UNKOWN;
   uint16_t slot_number = 0;
   uint16_t round_number = 0;
-  uint32_t backoff_time = chaos_random_generator_fast() % CHAOS_LEADER_ELECTION_TIMEOUT;
+  uint32_t backoff_time = chaos_random_generator_stream(CHAOS_RANDOM_STREAM_BACKOFF) % CHAOS_LEADER_ELECTION_TIMEOUT;
   //(2*CHAOS_NUMBER_OF_CHANNELS)
 
   /**/
@@ -1089,23 +1435,25 @@ uint8_t chaos_boot_election(rtimer_clock_t* t_sfd_actual_rtimer_ptr, uint16_t *r
     } else {
       *t_sfd_actual_rtimer_ptr = VHT_TO_RTIMER(sfd_vht);
       INITIATOR_NODE_ID = rx_header->initiator_id;
-      chaos_node_count = rx_header->chaos_node_count;
+      chaos_node_count = CHAOS_HEADER_GET_NODE_COUNT(rx_header);
       round_number = *round_number_ptr = rx_header->round_number;
       sync_round = round_number;
-      slot_number = rx_header->slot_number;
-      slot_number |= rx_header->slot_number_msb ? 0x100 : 0;
+      slot_number = CHAOS_HEADER_GET_SLOT_NUMBER(rx_header);
       *slot_number_ptr = slot_number;
-      *app_id_ptr = rx_header->id;
+      *app_id_ptr = CHAOS_HEADER_GET_APP_ID(rx_header);
       if(*app_id_ptr < chaos_app_count){
         app = chaos_apps[*app_id_ptr];
       } else{
         associated = 0;
       }
-      vht_clock_t slot_length = RTIMER_TO_VHT(app->slot_length);
+      vht_clock_t slot_length = RTIMER_TO_VHT(CHAOS_HEADER_SLOT_LENGTH(rx_header, app));
       round_rtimer = ROUND_START_FROM_SLOT(sfd_vht, slot_number, slot_length);
       round_synced = 1;
-      next_round_begin = rx_header->next_round_start;
-      next_round_id = rx_header->next_round_id;
+#if CHAOS_CO_INITIATORS
+      co_initiator_heard = 1;
+#endif /* CHAOS_CO_INITIATORS */
+      next_round_begin = CHAOS_INTERVAL_DECODE(rx_header->next_round_start);
+      next_round_id = CHAOS_HEADER_GET_NEXT_ROUND_ID(rx_header);
       slot_number++; //for logging to be similar to after association
       printf("{rd-%u st-%u ch-%u} ASC %s ID %u sfd_vht %lu, slot_number %u, slot_length %lu\n", round_number, slot_number, chaos_multichannel_get_current_channel(), CHAOS_RX_STATE_TO_STRING(rx_status), INITIATOR_NODE_ID, sfd_vht, slot_number, slot_length);
     }
@@ -1170,7 +1518,7 @@ uint8_t chaos_associate(rtimer_clock_t* t_sfd_actual_rtimer_ptr, uint16_t *round
         }
       } while(associated < 1 /*&& association_counter < CHAOS_ASSOCIATION_HOP_CHANNEL_THERSHOLD */); //XXX
         if( associated ){
-          *app_id_ptr = rx_header->id;
+          *app_id_ptr = CHAOS_HEADER_GET_APP_ID(rx_header);
           if(*app_id_ptr < chaos_app_count){
             app = chaos_apps[*app_id_ptr];
           }
@@ -1186,16 +1534,18 @@ uint8_t chaos_associate(rtimer_clock_t* t_sfd_actual_rtimer_ptr, uint16_t *round
     if( associated ){
       round_number = *round_number_ptr = rx_header->round_number;
       sync_round = round_number;
-      slot_number = rx_header->slot_number;
-      slot_number |= rx_header->slot_number_msb ? 0x100 : 0;
+      slot_number = CHAOS_HEADER_GET_SLOT_NUMBER(rx_header);
       *slot_number_ptr = slot_number;
-      vht_clock_t slot_length = RTIMER_TO_VHT(app->slot_length);
+      vht_clock_t slot_length = RTIMER_TO_VHT(CHAOS_HEADER_SLOT_LENGTH(rx_header, app));
       round_rtimer = ROUND_START_FROM_SLOT(sfd_vht, slot_number, slot_length);
       COOJA_DEBUG_PRINTF("sfd_vht %lu, slot_number %u, slot_length %lu, round_timer %lu",
           sfd_vht, slot_number, slot_length, round_rtimer);
       round_synced = 1;
-      next_round_begin = rx_header->next_round_start;
-      next_round_id = rx_header->next_round_id;
+#if CHAOS_CO_INITIATORS
+      co_initiator_heard = 1;
+#endif /* CHAOS_CO_INITIATORS */
+      next_round_begin = CHAOS_INTERVAL_DECODE(rx_header->next_round_start);
+      next_round_id = CHAOS_HEADER_GET_NEXT_ROUND_ID(rx_header);
       off();
       slot_number++; //for logging to be similar to after association
     }
@@ -1243,7 +1593,7 @@ int get_round_synced(){
   return round_synced;
 }
 
-rtimer_clock_t get_next_round_begin(){
+chaos_interval_t get_next_round_begin(){
   return next_round_begin;
 }
 
@@ -235,6 +235,20 @@ extern volatile uint16_t initiator_node_id;
 #define HAS_INITIATOR()              (0 != INITIATOR_NODE_ID)
 #define CHECK_INITIATOR(x)              ((x) == INITIATOR_NODE_ID)
 
+/**
+ * \brief Co-initiators: nodes in CHAOS_CO_INITIATOR_IDS that start the current round
+ * together with the initiator. Apps should use IS_ROUND_INITIATOR() to decide who transmits in the first slot.
+ */
+#if CHAOS_CO_INITIATORS
+uint8_t chaos_is_co_initiator(uint16_t id);
+uint8_t chaos_co_initiator_is_active(void);
+#define IS_CO_INITIATOR()           (chaos_is_co_initiator(node_id))
+#define IS_ROUND_INITIATOR()        (IS_INITIATOR() || chaos_co_initiator_is_active())
+#else
+#define IS_CO_INITIATOR()           (0)
+#define IS_ROUND_INITIATOR()        IS_INITIATOR()
+#endif /* CHAOS_CO_INITIATORS */
+
 /* For target Sky and Z1 */
 #define RSSI_CORRECTION_CONSTANT (-45)
 
@@ -354,7 +368,7 @@ uint16_t chaos_round(const uint16_t round_number, const uint8_t app_id, const ui
 uint8_t chaos_boot_election(rtimer_clock_t* t_sfd_actual_rtimer_ptr, uint16_t *round_number_ptr, uint16_t* slot_number_ptr, uint8_t* app_id_ptr);
 uint8_t chaos_associate(rtimer_clock_t* t_sfd_actual_rtimer_ptr, uint16_t *round_number_ptr, uint16_t* slot_number_ptr, uint8_t* app_id_ptr);
 uint8_t chaos_sniff_leader(timer_t* end_time);
-uint8_t compare_leaders_raw(uint16_t id1, uint8_t node_count1, uint16_t id2, uint8_t node_count2);
+uint8_t compare_leaders_raw(uint16_t id1, chaos_node_index_t node_count1, uint16_t id2, chaos_node_index_t node_count2);
 uint8_t compare_leaders(chaos_leader_t* a, chaos_leader_t* b);
 chaos_leader_t* get_sniffed_leader();
 void clear_sniffed_leader();
@@ -371,7 +385,7 @@ void set_round_rtimer(vht_clock_t rr);
 
 vht_clock_t get_round_start();
 
-rtimer_clock_t get_next_round_begin();
+chaos_interval_t get_next_round_begin();
 
 uint8_t get_next_round_id();
 
@@ -399,8 +413,28 @@ void
 chaos_make_const_nonce(uint8_t *nonce);
 
 const uint32_t * chaos_get_dummy_packet_32t();
+#if CHAOS_LARGE_SCALE
+#ifdef CHAOS_CONF_MAX_SLOTS_IN_ROUND
+#define MAX_SLOTS_IN_ROUND CHAOS_CONF_MAX_SLOTS_IN_ROUND
+#else
+#define MAX_SLOTS_IN_ROUND 2048
+#endif
+/* two slot states per byte */
+#define CHAOS_SLOT_LOG_SIZE ((MAX_SLOTS_IN_ROUND + 1) / 2)
+#define CHAOS_SLOT_LOG_GET(SLOT) ((chaos_slot_log[(SLOT) >> 1] >> (((SLOT) & 1) << 2)) & 0xf)
+#define CHAOS_SLOT_LOG_SET(SLOT, V) \
+  (chaos_slot_log[(SLOT) >> 1] = (chaos_slot_log[(SLOT) >> 1] & (0xf0 >> (((SLOT) & 1) << 2))) \
+    | ((MIN((V), 0xf)) << (((SLOT) & 1) << 2)))
+#else
 #define MAX_SLOTS_IN_ROUND 512
-extern uint8_t chaos_slot_log[MAX_SLOTS_IN_ROUND];
+#define CHAOS_SLOT_LOG_SIZE (MAX_SLOTS_IN_ROUND)
+#define CHAOS_SLOT_LOG_GET(SLOT) (chaos_slot_log[(SLOT)])
+#define CHAOS_SLOT_LOG_SET(SLOT, V) (chaos_slot_log[(SLOT)] = (V))
+#endif /* CHAOS_LARGE_SCALE */
+extern uint8_t chaos_slot_log[CHAOS_SLOT_LOG_SIZE];
+#if MAX_SLOTS_IN_ROUND > CHAOS_HEADER_MAX_SLOTS
+#error "MAX_SLOTS_IN_ROUND does not fit the header slot number, enable CHAOS_LARGE_SCALE"
+#endif
 #define CHAOS_SLOT_STATS_SIZE (16)
 extern uint16_t chaos_slot_stats[CHAOS_SLOT_STATS_SIZE];
 enum {TX_PREPARE=0, RX_PREPARE, TX, RX, TX_POST, RX_POST, JOIN_PROCESSING, APP_PROCESSING, SLOT_END_PROCCESSING, SLOT_TIME_ALL, SLOTNUMBER, SLOT_TIMING_SIZE};
@@ -408,5 +442,27 @@ extern rtimer_clock_t chaos_slot_timing_log_max[SLOT_TIMING_SIZE];
 extern rtimer_clock_t chaos_slot_timing_log_min[SLOT_TIMING_SIZE];
 extern uint32_t chaos_slot_timing_rx_sum;
 extern uint32_t chaos_slot_timing_tx_sum;
+#if CHAOS_SLOT_TIMING_HISTOGRAM
+/* per app and timing phase (SLOTNUMBER excluded), see CHAOS_SLOT_TIMING_HISTOGRAM_SHIFT */
+extern uint16_t chaos_slot_timing_histogram[CHAOS_SLOT_TIMING_HISTOGRAM_APPS][SLOTNUMBER][CHAOS_SLOT_TIMING_HISTOGRAM_BUCKETS];
+#endif /* CHAOS_SLOT_TIMING_HISTOGRAM */
+
+/* Radio and CPU active time of the slots. Radio time counts from the last rtimer tick
+ * before tx/rx, so it misses less than one tick of warm-up per slot */
+typedef struct {
+  uint32_t radio_tx; /* radio on for a transmission */
+  uint32_t radio_listen; /* radio on without receiving: guard time, timeouts */
+  uint32_t radio_rx; /* radio receiving a frame */
+  uint32_t cpu; /* slot processing, without the (LPM) wait for the slot end */
+} chaos_energy_t;
+/* last round, in DCO ticks; NULL without CHAOS_ENERGY_ACCOUNTING */
+const chaos_energy_t* chaos_get_energy_round(void);
+/* all rounds of an app since boot, in us; NULL without CHAOS_ENERGY_ACCOUNTING */
+const chaos_energy_t* chaos_get_energy_app(uint8_t app_id);
+
+/* slots skipped because of processing overruns since boot */
+uint16_t chaos_get_slot_overruns(uint8_t app_id);
+/* slots run in the last round */
+uint16_t chaos_get_round_slots(void);
 
 #endif /* CHAOS_H_ */
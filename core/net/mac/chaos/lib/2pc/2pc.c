@@ -42,6 +42,7 @@
 
 #include "chaos.h"
 #include "chaos-random-generator.h"
+#include "chaos-termination.h"
 #include "node.h"
 #include "2pc.h"
 #include "chaos-config.h"
@@ -206,6 +207,7 @@ process(uint16_t round_count, uint16_t slot_count, chaos_state_t current_state,
         }
         complete = 1;
         rx_progress |= (rx_flag_sum == FLAG_SUM); /* received a complete packet */
+        CHAOS_TERMINATION_RX_COMPLETE(rx_flag_sum != FLAG_SUM);
       }
     } else if( tx_two_pc->phase < rx_two_pc->phase ){
       //received phase is more advanced than local one -> switch to received state (and set own flags)
@@ -235,9 +237,9 @@ process(uint16_t round_count, uint16_t slot_count, chaos_state_t current_state,
       if( complete ){
         tx_count_complete++;
       }
-      restart_threshold = chaos_random_generator_fast() % (CHAOS_RESTART_MAX - CHAOS_RESTART_MIN) + CHAOS_RESTART_MIN;
+      restart_threshold = CHAOS_RESTART_THRESHOLD();
     }
-  } else if(current_state == CHAOS_TX && (rx_progress || !RELIABLE_FF) && tx_count_complete >= N_TX_COMPLETE){
+  } else if(current_state == CHAOS_TX && (rx_progress || !RELIABLE_FF) && tx_count_complete >= CHAOS_N_TX_COMPLETE()){
     next_state = CHAOS_OFF;
     leds_off(LEDS_GREEN);
   }
@@ -246,7 +248,7 @@ process(uint16_t round_count, uint16_t slot_count, chaos_state_t current_state,
 
 #if FAILURES_RATE
 #warning "INJECT_FAILURES!!"
-  if(/*tx_two_pc->phase == PHASE_PROPOSE && */chaos_random_generator_fast() < 1*(CHAOS_RANDOM_MAX/(FAILURES_RATE))){
+  if(/*tx_two_pc->phase == PHASE_PROPOSE && */chaos_random_generator_stream(CHAOS_RANDOM_STREAM_FAILURES) < 1*(CHAOS_RANDOM_STREAM_MAX/(FAILURES_RATE))){
     next_state = CHAOS_OFF;
   }
 #endif
@@ -307,7 +309,7 @@ int two_pc_round_begin(const uint16_t round_number, const uint8_t app_id, uint32
   rx_progress = 0;
 
   /* init random restart threshold */
-  restart_threshold = chaos_random_generator_fast() % (CHAOS_RESTART_MAX - CHAOS_RESTART_MIN) + CHAOS_RESTART_MIN;
+  restart_threshold = CHAOS_RESTART_THRESHOLD();
 
   memset(&two_pc_local, 0, sizeof(two_pc_local));
   two_pc_local.two_pc.value = *two_pc_value;
@@ -42,6 +42,7 @@
 
 #include "chaos.h"
 #include "chaos-random-generator.h"
+#include "chaos-termination.h"
 #include "node.h"
 #include "3pc.h"
 #include "chaos-config.h"
@@ -236,6 +237,7 @@ process(uint16_t round_count, uint16_t slot_count, chaos_state_t current_state,
               }
               complete = 1;
               rx_progress |= (rx_flag_sum == FLAG_SUM); /* received a complete packet */
+              CHAOS_TERMINATION_RX_COMPLETE(rx_flag_sum != FLAG_SUM);
             } else {
               //XXX this should not happen... not everybody have committed -> FAIL
               memset(tx_flags, 0, three_pc_get_flags_length());
@@ -252,6 +254,7 @@ process(uint16_t round_count, uint16_t slot_count, chaos_state_t current_state,
             }
             complete = 1;
             rx_progress |= (rx_flag_sum == FLAG_SUM); /* received a complete packet */
+            CHAOS_TERMINATION_RX_COMPLETE(rx_flag_sum != FLAG_SUM);
           }
         }
       } else if( tx_three_pc->phase < rx_three_pc->phase ){
@@ -305,9 +308,9 @@ process(uint16_t round_count, uint16_t slot_count, chaos_state_t current_state,
       if( complete ){
         tx_count_complete++;
       }
-      restart_threshold = chaos_random_generator_fast() % (CHAOS_RESTART_MAX - CHAOS_RESTART_MIN) + CHAOS_RESTART_MIN;
+      restart_threshold = CHAOS_RESTART_THRESHOLD();
     }
-  } else if(current_state == CHAOS_TX && (rx_progress || !RELIABLE_FF) && tx_count_complete >= N_TX_COMPLETE){
+  } else if(current_state == CHAOS_TX && (rx_progress || !RELIABLE_FF) && tx_count_complete >= CHAOS_N_TX_COMPLETE()){
     next_state = CHAOS_OFF;
     leds_off(LEDS_GREEN);
   }
@@ -318,7 +321,7 @@ process(uint16_t round_count, uint16_t slot_count, chaos_state_t current_state,
 
 #if FAILURES_RATE
 #warning "INJECT_FAILURES!!"
-  if(chaos_random_generator_fast() < 1*(CHAOS_RANDOM_MAX/(FAILURES_RATE))){
+  if(chaos_random_generator_stream(CHAOS_RANDOM_STREAM_FAILURES) < 1*(CHAOS_RANDOM_STREAM_MAX/(FAILURES_RATE))){
     next_state = CHAOS_OFF;
   }
 #endif
@@ -388,7 +391,7 @@ int three_pc_round_begin(const uint16_t round_number, const uint8_t app_id, uint
   rx_progress = 0;
 
   /* init random restart threshold */
-  restart_threshold = chaos_random_generator_fast() % (CHAOS_RESTART_MAX - CHAOS_RESTART_MIN) + CHAOS_RESTART_MIN;
+  restart_threshold = CHAOS_RESTART_THRESHOLD();
 
 #if THREE_PC_LOG_FLAGS
   memset(&chaos_3pc_flags_log, 0, sizeof(chaos_3pc_flags_log));
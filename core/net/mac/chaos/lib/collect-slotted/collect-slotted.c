@@ -112,7 +112,7 @@ collect_process(uint16_t round_count, uint16_t slot_count, chaos_state_t current
   }
 
 
-  if( IS_INITIATOR() && current_state == CHAOS_INIT ){
+  if( IS_ROUND_INITIATOR() && current_state == CHAOS_INIT ){
     next_state = CHAOS_TX;
     tx_count++;
     *first_rx_hop_count_local = 0;
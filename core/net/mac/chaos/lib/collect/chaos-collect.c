@@ -202,7 +202,7 @@ process(uint16_t round_count, uint16_t slot_count, chaos_state_t current_state,
 
   /* decide next state */
   chaos_state_t next_state = CHAOS_RX;
-  if( IS_INITIATOR() && current_state == CHAOS_INIT ){
+  if( IS_ROUND_INITIATOR() && current_state == CHAOS_INIT ){
     next_state = CHAOS_TX; //for the first tx of the initiator: no increase of tx_count here
     got_valid_rx = 1; //to enable retransmissions
   } else if(current_state == CHAOS_RX && chaos_txrx_success){
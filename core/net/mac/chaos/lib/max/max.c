@@ -42,6 +42,7 @@
 
 #include "chaos.h"
 #include "chaos-random-generator.h"
+#include "chaos-termination.h"
 #include "node.h"
 #include "max.h"
 #include "chaos-config.h"
@@ -148,7 +149,7 @@ process(uint16_t round_count, uint16_t slot_count, chaos_state_t current_state,
 
   /* decide next state */
   chaos_state_t next_state = CHAOS_RX;
-  if( IS_INITIATOR() && current_state == CHAOS_INIT ){
+  if( IS_ROUND_INITIATOR() && current_state == CHAOS_INIT ){
     next_state = CHAOS_TX; //for the first tx of the initiator: no increase of tx_count here
     got_valid_rx = 1; //to enable retransmissions
   } else if(current_state == CHAOS_RX && chaos_txrx_success){
@@ -157,6 +158,7 @@ process(uint16_t round_count, uint16_t slot_count, chaos_state_t current_state,
       /* if we have not received a delta, then we limit tx rate */
       next_state = CHAOS_TX;
       if( complete ){
+        CHAOS_TERMINATION_RX_COMPLETE(rx_delta);
         if(rx_delta){
           tx_count_complete = 0;
         } else {
@@ -172,12 +174,12 @@ process(uint16_t round_count, uint16_t slot_count, chaos_state_t current_state,
       if( complete ){
         tx_count_complete++;
       }
-      restart_threshold = chaos_random_generator_fast() % (CHAOS_RESTART_MAX - CHAOS_RESTART_MIN) + CHAOS_RESTART_MIN;
+      restart_threshold = CHAOS_RESTART_THRESHOLD();
     }
   } else if(current_state == CHAOS_TX && !chaos_txrx_success){ /* we missed tx go time. Retry */
     got_valid_rx = 1; //????? check me!
     next_state = CHAOS_TX;
-  } else if(current_state == CHAOS_TX && tx_count_complete > N_TX_COMPLETE){
+  } else if(current_state == CHAOS_TX && tx_count_complete > CHAOS_N_TX_COMPLETE()){
     next_state = CHAOS_OFF;
     LEDS_OFF(LEDS_GREEN);
   }
@@ -221,7 +223,7 @@ int max_round_begin(const uint16_t round_number, const uint8_t app_id, uint16_t*
   invalid_rx_count = 0;
 
   /* init random restart threshold */
-  restart_threshold = chaos_random_generator_fast() % (CHAOS_RESTART_MAX - CHAOS_RESTART_MIN) + CHAOS_RESTART_MIN;
+  restart_threshold = CHAOS_RESTART_THRESHOLD();
 
   memset(&max_local, 0, sizeof(max_local));
   max_local.max.max = *max_value;
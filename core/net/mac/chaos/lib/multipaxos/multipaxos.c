@@ -43,6 +43,8 @@
 
 #include "chaos-config.h"
 #include "chaos-random-generator.h"
+#include "chaos-termination.h"
+#include "chaos-probe.h"
 #include "chaos.h"
 #include "multipaxos.h"
 #include "node.h"
@@ -73,7 +75,7 @@ static uint8_t bit_count(uint8_t u) { return (u - (u >> 1) - (u >> 2) - (u >> 3)
 
 #if MULTIPAXOS_ADVANCED_STATISTICS
 /* Number of flags set as locally seen by the node, for each Synchrotron slot */
-uint8_t multipaxos_statistics_flags_evolution_per_slot[MULTIPAXOS_ROUND_MAX_SLOTS] = {0};
+chaos_node_index_t multipaxos_statistics_flags_evolution_per_slot[MULTIPAXOS_ROUND_MAX_SLOTS] = {0};
 /* Local Multi-Paxos log of accepted values */
 multipaxos_value_t multipaxos_statistics_values_in_log[MULTIPAXOS_LOG_SIZE] = {0};
 #endif /* MULTIPAXOS_ADVANCED_STATISTICS */
@@ -199,11 +201,13 @@ static chaos_state_t process(uint16_t round_count, uint16_t slot_count, chaos_st
         memcpy(tx_multipaxos, payload, sizeof(multipaxos_t));
         uint16_t flag_sum = 0;
         uint8_t i;
+        CHAOS_PROBE_BEGIN(merge);
         for (i = 0; i < FLAGS_LEN; i++) {
           tx |= (payload->flags[i] != tx_multipaxos->flags[i]);
           tx_multipaxos->flags[i] |= payload->flags[i];
           flag_sum += tx_multipaxos->flags[i];
         }
+        CHAOS_PROBE_END(merge, CHAOS_PROBE_FLAG_MERGE);
         if (flag_sum >= FLAG_SUM) {
           complete = 1;
         }
@@ -333,6 +337,7 @@ static chaos_state_t process(uint16_t round_count, uint16_t slot_count, chaos_st
         uint16_t i;
         if (!new_phase) {
           /* Set Synchrotron participation (progress) flags */
+          CHAOS_PROBE_BEGIN(merge);
           for (i = 0; i < FLAGS_LEN; i++) { /* not a new phase, merge heard flags with the
                                                last flags we transmitted */
             n_replies += bit_count(tx_multipaxos->flags[i]);
@@ -341,6 +346,7 @@ static chaos_state_t process(uint16_t round_count, uint16_t slot_count, chaos_st
             tx_multipaxos->flags[i] |= payload->flags[i];
             flag_sum += tx_multipaxos->flags[i];
           }
+          CHAOS_PROBE_END(merge, CHAOS_PROBE_FLAG_MERGE);
         } else if (new_phase) {
           /* new phase received, flags have been copied already */
           for (i = 0; i < FLAGS_LEN; i++) {
@@ -561,7 +567,7 @@ static chaos_state_t process(uint16_t round_count, uint16_t slot_count, chaos_st
   chaos_state_t next_state = CHAOS_RX;
 
   /* beginning of a Synchrotron round */
-  if (IS_INITIATOR() && current_state == CHAOS_INIT) {
+  if (IS_ROUND_INITIATOR() && current_state == CHAOS_INIT) {
     next_state = CHAOS_TX;
     got_valid_rx = 1; /* enables retransmissions */
 
@@ -611,6 +617,7 @@ static chaos_state_t process(uint16_t round_count, uint16_t slot_count, chaos_st
       /* if we have not received a delta, then we limit tx rate */
       next_state = CHAOS_TX;
       if (complete) {
+        CHAOS_TERMINATION_RX_COMPLETE(rx_delta);
         if (rx_delta) {
           tx_count_complete = 0;
         } else {
@@ -626,12 +633,12 @@ static chaos_state_t process(uint16_t round_count, uint16_t slot_count, chaos_st
       if (complete) {
         tx_count_complete++;
       }
-      restart_threshold = chaos_random_generator_fast() % (CHAOS_RESTART_MAX - CHAOS_RESTART_MIN) + CHAOS_RESTART_MIN;
+      restart_threshold = CHAOS_RESTART_THRESHOLD();
     }
   } else if (current_state == CHAOS_TX && !chaos_txrx_success) { /* we missed tx go time. Retry */
     got_valid_rx = 1;
     next_state = CHAOS_TX;
-  } else if (current_state == CHAOS_TX && tx_count_complete > N_TX_COMPLETE) {
+  } else if (current_state == CHAOS_TX && tx_count_complete > CHAOS_N_TX_COMPLETE()) {
     next_state = CHAOS_OFF;
     LEDS_OFF(LEDS_GREEN);
   }
@@ -642,7 +649,7 @@ static chaos_state_t process(uint16_t round_count, uint16_t slot_count, chaos_st
 /* Inject random failures - for evaluation */
 #if FAILURES_RATE
 #warning "INJECT_FAILURES!!"
-  if (chaos_random_generator_fast() < 1 * (CHAOS_RANDOM_MAX / (FAILURES_RATE))) {
+  if (chaos_random_generator_stream(CHAOS_RANDOM_STREAM_FAILURES) < 1 * (CHAOS_RANDOM_STREAM_MAX / (FAILURES_RATE))) {
     next_state = CHAOS_OFF;
   }
 #endif
@@ -727,7 +734,7 @@ void multipaxos_initialize_variables_for_new_round() {
   invalid_rx_count = 0;
   values_chosen_this_round = 0;
   /* init random restart threshold */
-  restart_threshold = chaos_random_generator_fast() % (CHAOS_RESTART_MAX - CHAOS_RESTART_MIN) + CHAOS_RESTART_MIN;
+  restart_threshold = CHAOS_RESTART_THRESHOLD();
   /* set my flag */
   unsigned int array_index = chaos_node_index / 8;
   unsigned int array_offset = chaos_node_index % 8;
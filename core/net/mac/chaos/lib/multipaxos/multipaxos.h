@@ -107,12 +107,22 @@ A ballot is made of two elements:
 loss
   - id (LSB): node id, used to have unique ballot numbers
 */
+#if CHAOS_LARGE_SCALE
+/* 16-bit node indices */
+typedef union __attribute__((packed)) ballot_number_t_struct {
+    uint32_t n;
+    struct {
+        uint32_t id : 16, round : 16;
+    };
+} ballot_number_t;
+#else
 typedef union __attribute__((packed)) ballot_number_t_struct {
     uint16_t n;
     struct {
         uint16_t id : 8, round : 8;
     };
 } ballot_number_t;
+#endif /* CHAOS_LARGE_SCALE */
 
 /* Wireless Paxos value type
 The value is the actual data being agreed on
@@ -296,7 +306,7 @@ extern uint8_t not_heard_from_leader_since;
 
 #if MULTIPAXOS_ADVANCED_STATISTICS
 /* Number of flags set as locally seen by the node, for each Synchrotron slot */
-extern uint8_t
+extern chaos_node_index_t
     multipaxos_statistics_flags_evolution_per_slot[MULTIPAXOS_ROUND_MAX_SLOTS];
 /* Final values in the log at the end of the Synchrotron round */
 extern multipaxos_value_t
@@ -43,6 +43,8 @@
 
 #include "chaos-config.h"
 #include "chaos-random-generator.h"
+#include "chaos-termination.h"
+#include "chaos-probe.h"
 #include "chaos.h"
 #include "node.h"
 #include "paxos.h"
@@ -83,7 +85,7 @@ static uint8_t bit_count(uint8_t u) { return (u - (u >> 1) - (u >> 2) - (u >> 3)
 
 #if PAXOS_ADVANCED_STATISTICS
 /* Number of flags set as locally seen by the node, for each Synchrotron slot */
-uint8_t paxos_statistics_flags_evolution_per_slot[PAXOS_ROUND_MAX_SLOTS] = {0};
+chaos_node_index_t paxos_statistics_flags_evolution_per_slot[PAXOS_ROUND_MAX_SLOTS] = {0};
 /* Locally saved accepted value, for each Synchrotron slot */
 paxos_value_t paxos_statistics_value_evolution_per_slot[PAXOS_ROUND_MAX_SLOTS] = {0};
 /* Locally saved min proposal, for each Synchrotron slot */
@@ -207,11 +209,13 @@ static chaos_state_t process(uint16_t round_count, uint16_t slot_count, chaos_st
         memcpy(tx_paxos, payload, sizeof(paxos_t)); /* TODO remove? */
         uint16_t flag_sum = 0;
         int i;
+        CHAOS_PROBE_BEGIN(merge);
         for (i = 0; i < FLAGS_LEN; i++) {
           tx |= (rx_paxos->flags[i] != tx_paxos->flags[i]);
           tx_paxos->flags[i] |= rx_paxos->flags[i];
           flag_sum += tx_paxos->flags[i];
         }
+        CHAOS_PROBE_END(merge, CHAOS_PROBE_FLAG_MERGE);
         if (flag_sum >= FLAG_SUM) {
           complete = 1;
         }
@@ -321,12 +325,14 @@ static chaos_state_t process(uint16_t round_count, uint16_t slot_count, chaos_st
         int i;
         if (!new_phase) {
           /* We didn't memcopy, we need to merge flags */
+          CHAOS_PROBE_BEGIN(merge);
           for (i = 0; i < FLAGS_LEN; i++) {
             rx_delta |= (payload->flags[i] != tx_paxos->flags[i]);
             tx_paxos->flags[i] |= payload->flags[i];
             flag_sum += tx_paxos->flags[i];
             n_replies += bit_count(tx_paxos->flags[i]);
           }
+          CHAOS_PROBE_END(merge, CHAOS_PROBE_FLAG_MERGE);
         } else if (new_phase) {
           tx = rx_delta = 1;
           for (i = 0; i < FLAGS_LEN; i++) {
@@ -350,7 +356,7 @@ static chaos_state_t process(uint16_t round_count, uint16_t slot_count, chaos_st
          * starts the second phase faster
          */
         if (!paxos_state.proposer.is_proposer && payload->phase == PAXOS_PREPARE && (n_replies > (chaos_node_count / 2)) && tx == 1) {
-          tx = (chaos_random_generator_fast() % (chaos_node_count / 2) == 0) ? 1 : 0; /* We reduce tx rate to improve transition
+          tx = (chaos_random_generator_stream(CHAOS_RANDOM_STREAM_TX_RATE) % (chaos_node_count / 2) == 0) ? 1 : 0; /* We reduce tx rate to improve transition
                                                                                          time */
         }
 
@@ -548,10 +554,11 @@ static chaos_state_t process(uint16_t round_count, uint16_t slot_count, chaos_st
   uint8_t initiate_round = 0;
   /* if more than one Synchrotron initiators are present */
 #if ENABLE_MULTIPLE_INITIATORS
-  /* Warning! Might cause timing issues if enabled */
+  /* Warning! Might cause timing issues if enabled: the kernel does not treat these nodes as time sources.
+   * Prefer CHAOS_CO_INITIATOR_IDS, which makes the kernel start the round on the co-initiators */
   initiate_round = chaos_node_index < N_SOURCES;
 #else
-  initiate_round = IS_INITIATOR();
+  initiate_round = IS_ROUND_INITIATOR();
 #endif
   if (initiate_round && current_state == CHAOS_INIT) {
     next_state = CHAOS_TX;
@@ -568,7 +575,7 @@ static chaos_state_t process(uint16_t round_count, uint16_t slot_count, chaos_st
     }
     /* END PROPOSER - INITIATE PAXOS ALGORITHM (3/3)*/
 
-  } else if (tx_count_complete > N_TX_COMPLETE) { /* Round is completed and we transmitted
+  } else if (tx_count_complete > CHAOS_N_TX_COMPLETE()) { /* Round is completed and we transmitted
                                                      multiple time after completion */
     next_state = CHAOS_OFF;
     LEDS_OFF(LEDS_GREEN);
@@ -577,6 +584,7 @@ static chaos_state_t process(uint16_t round_count, uint16_t slot_count, chaos_st
     if (tx) {
       next_state = CHAOS_TX;
       if (complete) {
+        CHAOS_TERMINATION_RX_COMPLETE(rx_delta);
         if (rx_delta) {
           tx_count_complete = 0;
         } else {
@@ -592,7 +600,7 @@ static chaos_state_t process(uint16_t round_count, uint16_t slot_count, chaos_st
       if (complete) {
         tx_count_complete++;
       }
-      restart_threshold = chaos_random_generator_fast() % (CHAOS_RESTART_MAX - CHAOS_RESTART_MIN) + CHAOS_RESTART_MIN;
+      restart_threshold = CHAOS_RESTART_THRESHOLD();
     }
   } else if (current_state == CHAOS_TX && !chaos_txrx_success) { /* we missed tx go time. Retry */
     got_valid_rx = 1;                                            /* Trick from Chaos. TODO keep it? */
@@ -601,7 +609,7 @@ static chaos_state_t process(uint16_t round_count, uint16_t slot_count, chaos_st
 
 #if FAILURES_RATE
 #warning "INJECT_FAILURES!!"
-  if (chaos_random_generator_fast() < 1 * (CHAOS_RANDOM_MAX / (FAILURES_RATE))) {
+  if (chaos_random_generator_stream(CHAOS_RANDOM_STREAM_FAILURES) < 1 * (CHAOS_RANDOM_STREAM_MAX / (FAILURES_RATE))) {
     next_state = CHAOS_OFF;
   }
 #endif
@@ -729,7 +737,7 @@ uint8_t paxos_round_begin(const uint16_t round_number, const uint8_t app_id, uin
   invalid_rx_count = 0; /* invalid reception counter */
   value_chosen_this_round = 0; /* Was a value chosen this round */
   /* init random TX timeout backoff */
-  restart_threshold = chaos_random_generator_fast() % (CHAOS_RESTART_MAX - CHAOS_RESTART_MIN) + CHAOS_RESTART_MIN;
+  restart_threshold = CHAOS_RESTART_THRESHOLD();
 #if PAXOS_ADVANCED_STATISTICS
   paxos_statistics_min_proposal_last_update = 0; /* used to save space when printing statistics */
   paxos_statistics_accepted_proposal_last_update = 0; /* used to save space when printing statistics */
@@ -73,12 +73,22 @@
  *                  loss
  *   - id (LSB): node id, used to have unique ballot numbers
  */
+#if CHAOS_LARGE_SCALE
+/* 16-bit node indices */
+typedef union __attribute__((packed)) ballot_number_t_struct {
+  uint32_t n;
+  struct {
+    uint32_t id : 16, round : 16;
+  };
+} ballot_number_t;
+#else
 typedef union __attribute__((packed)) ballot_number_t_struct {
   uint16_t n;
   struct {
     uint16_t id : 8, round : 8;
   };
 } ballot_number_t;
+#endif /* CHAOS_LARGE_SCALE */
 
 /* Wireless Paxos value type
  * The value is the actual data being agreed on
@@ -233,7 +243,7 @@ paxos_value_t paxos_get_learned_value();
 
 #if PAXOS_ADVANCED_STATISTICS
 /* Number of flags set as locally seen by the node, for each Synchrotron slot */
-extern uint8_t paxos_statistics_flags_evolution_per_slot[PAXOS_ROUND_MAX_SLOTS];
+extern chaos_node_index_t paxos_statistics_flags_evolution_per_slot[PAXOS_ROUND_MAX_SLOTS];
 /* Locally saved accepted value, for each Synchrotron slot */
 extern uint8_t paxos_statistics_value_evolution_per_slot[PAXOS_ROUND_MAX_SLOTS];
 /* Locally saved min proposal, for each Synchrotron slot */
@@ -42,6 +42,7 @@
 
 #include "chaos.h"
 #include "chaos-random-generator.h"
+#include "chaos-termination.h"
 #include "node.h"
 #include "vote.h"
 #include "chaos-config.h"
@@ -171,6 +172,7 @@ process(uint16_t round_count, uint16_t slot_count, chaos_state_t current_state,
       rx_flag_sum += rx_vote->flags[i];
     }
     rx_progress |= (rx_flag_sum >= FLAG_SUM); /* received a complete packet */
+    CHAOS_TERMINATION_RX_COMPLETE(rx_flag_sum < FLAG_SUM);
   }
 
   /* decide next state */
@@ -195,12 +197,12 @@ process(uint16_t round_count, uint16_t slot_count, chaos_state_t current_state,
       if( complete ){
         tx_count_complete++;
       }
-      restart_threshold = chaos_random_generator_fast() % (CHAOS_RESTART_MAX - CHAOS_RESTART_MIN) + CHAOS_RESTART_MIN;
+      restart_threshold = CHAOS_RESTART_THRESHOLD();
     }
   } else if(current_state == CHAOS_TX && !chaos_txrx_success){ /* we missed tx go time. Retry */
     got_valid_rx = 1; //????? check me!
     next_state = CHAOS_TX;
-  } else if(current_state == CHAOS_TX && (rx_progress || !RELIABLE_FF) && tx_count_complete >= N_TX_COMPLETE){
+  } else if(current_state == CHAOS_TX && (rx_progress || !RELIABLE_FF) && tx_count_complete >= CHAOS_N_TX_COMPLETE()){
     next_state = CHAOS_OFF;
     LEDS_OFF(LEDS_GREEN);
   }
@@ -210,7 +212,7 @@ process(uint16_t round_count, uint16_t slot_count, chaos_state_t current_state,
 
 #if FAILURES_RATE
 #warning "INJECT_FAILURES!!"
-  if(chaos_random_generator_fast() < 1*(CHAOS_RANDOM_MAX/(FAILURES_RATE))){
+  if(chaos_random_generator_stream(CHAOS_RANDOM_STREAM_FAILURES) < 1*(CHAOS_RANDOM_STREAM_MAX/(FAILURES_RATE))){
     next_state = CHAOS_OFF;
   }
 #endif
@@ -265,7 +267,7 @@ int vote_round_begin(const uint16_t round_number, const uint8_t app_id, uint32_t
   rx_progress = 0;
 
   /* init random restart threshold */
-  restart_threshold = chaos_random_generator_fast() % (CHAOS_RESTART_MAX - CHAOS_RESTART_MIN) + CHAOS_RESTART_MIN;
+  restart_threshold = CHAOS_RESTART_THRESHOLD();
 
   memset(&vote_local, 0, sizeof(vote_local));
   if( IS_INITIATOR() ){
@@ -44,8 +44,8 @@
 #include "node.h"
 #include "net/mac/chaos/node/testbed.h"
 
-volatile uint8_t chaos_node_index = 0;
-volatile uint8_t chaos_node_count = 0;
+volatile chaos_node_index_t chaos_node_index = 0;
+volatile chaos_node_index_t chaos_node_count = 0;
 volatile uint8_t chaos_has_node_index = 0;
 
 #if NETSTACK_CONF_WITH_CHAOS_LEADER_ELECTION
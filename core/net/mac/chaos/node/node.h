@@ -58,6 +58,10 @@ uint8_t has_stable_initiator();
 #error "MAX_NODE_COUNT is not defined"
 #endif
 
+#if MAX_NODE_COUNT > CHAOS_HEADER_MAX_NODES
+#error "MAX_NODE_COUNT does not fit the header node count, enable CHAOS_LARGE_SCALE"
+#endif
+
 //#ifndef MAX_NODE_COUNT
 //#define MAX_NODE_COUNT MAX_NODE_COUNT_TESTBED
 //#endif
@@ -68,8 +72,8 @@ uint8_t has_stable_initiator();
 extern volatile uint16_t initiator_node_id;
 #endif
 
-extern volatile uint8_t chaos_node_count;  //only valid on initiator
-extern volatile uint8_t chaos_node_index;
+extern volatile chaos_node_index_t chaos_node_count;  //only valid on initiator
+extern volatile chaos_node_index_t chaos_node_index;
 extern volatile uint8_t chaos_has_node_index;
 
 #define CHAOS_NODES chaos_node_count
@@ -79,9 +83,9 @@ extern volatile uint8_t chaos_has_node_index;
 #define CHAOS_NODES 1
 #endif
 
-extern uint8_t chaos_node_index;
+extern chaos_node_index_t chaos_node_index;
 extern uint8_t chaos_has_node_index;
-extern const uint8_t chaos_node_count;
+extern const chaos_node_index_t chaos_node_count;
 
 #endif  /* NETSTACK_CONF_WITH_CHAOS_NODE_DYNAMIC */
 #endif	/* _NODE_H */
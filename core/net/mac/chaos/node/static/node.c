@@ -43,9 +43,9 @@
 #include "node-id.h"
 #include "net/mac/chaos/node/testbed.h"
 
-uint8_t chaos_node_index = 0;
+chaos_node_index_t chaos_node_index = 0;
 uint8_t chaos_has_node_index = 0;
-const uint8_t chaos_node_count = (CHAOS_NODES);
+const chaos_node_index_t chaos_node_count = (CHAOS_NODES);
 const uint16_t mapping[] = (uint16_t[])TESTBED_MAPPING;
 
 #if TESTBED > 0 && !NO_TESTBED_ID_MAP /* 0 is cooja or no testbed */
@@ -0,0 +1,196 @@
+/*******************************************************************************
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017 Beshr Al Nahas and Olaf Landsiedel.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+/**
+ * \file
+ *         Hopping service: PRR-weighted hopping sequence, disseminated piggybacked on the rounds of the other apps.
+ * \author
+ *         Beshr Al Nahas <beshr@chalmers.se>
+ *         Olaf Landsiedel <olafl@chalmers.se>
+ */
+
+#include "contiki.h"
+#include <string.h>
+
+#include "chaos.h"
+#include "chaos-control.h"
+#include "chaos-config.h"
+#include "chaos-multichannel.h"
+#include "chaos-piggyback.h"
+#include "hopping.h"
+
+#if CHAOS_HOPPING_REGENERATION && CHAOS_MULTI_CHANNEL
+
+#if !CHAOS_PIGGYBACK
+#error "CHAOS_HOPPING_REGENERATION needs CHAOS_PIGGYBACK"
+#endif
+
+/* 4-bit weight per channel, two channels per byte */
+#define WEIGHTS_LEN (CHAOS_NUMBER_OF_CHANNELS / 2)
+#define WEIGHT_GET(W, I) (((W)[(I) >> 1] >> (((I) & 1) << 2)) & 0xf)
+#define WEIGHT_SET(W, I, V) ((W)[(I) >> 1] = ((W)[(I) >> 1] & (0xf0 >> (((I) & 1) << 2))) | ((V) << (((I) & 1) << 2)))
+/* bad channels keep a minimum weight, so that their PRR can recover */
+#define WEIGHT_MIN 1
+#define WEIGHT_MAX 15
+/* who set epoch and weights of a sub-payload, the higher one wins. The epoch itself is
+ * no order: it restarts when the initiator reboots or another node takes over */
+#define SOURCE_NODE 0
+#define SOURCE_CO_INITIATOR 1
+#define SOURCE_INITIATOR 2
+
+#define HOPPING_SLOT_LEN (RTIMER_SECOND/250)
+#define HOPPING_ROUND_MAX_SLOTS 1
+
+typedef struct __attribute__((packed)) {
+  uint8_t epoch;
+  uint8_t source; /* SOURCE_* of epoch and weights */
+  uint8_t weights[WEIGHTS_LEN]; /* from the initiator */
+  uint8_t collected[WEIGHTS_LEN]; /* network-wide minimum of the channel quality */
+} hopping_t;
+
+static uint8_t epoch = 0, weights_changed = 0;
+static uint8_t weights[WEIGHTS_LEN];
+static uint8_t collected[WEIGHTS_LEN];
+static uint8_t collected_valid = 0;
+
+static int is_pending(const uint16_t round_count);
+static void round_begin(const uint16_t round_count, const uint8_t id);
+static void rider_round_begin(const uint16_t round_count, uint8_t* tx_payload);
+static chaos_state_t process(uint16_t round_count, uint16_t slot_count, chaos_state_t current_state,
+    int chaos_txrx_success, size_t payload_length, uint8_t* rx_payload, uint8_t* tx_payload, uint8_t** app_flags);
+static void rider_round_end(const uint16_t round_count, const uint8_t* payload);
+
+static const chaos_piggyback_t hopping_piggyback = {sizeof(hopping_t), rider_round_begin, process, rider_round_end};
+
+CHAOS_PIGGYBACK_APP(hopping, HOPPING_SLOT_LEN, HOPPING_ROUND_MAX_SLOTS, 0, is_pending, round_begin, &hopping_piggyback);
+
+static uint8_t
+channel_quality(uint8_t channel_idx) {
+  uint16_t q = chaos_multichannel_get_channel_prr(channel_idx) >> 4;
+  return MAX(MIN(q, WEIGHT_MAX), WEIGHT_MIN);
+}
+
+static void
+apply_weights(void) {
+  uint8_t w[CHAOS_NUMBER_OF_CHANNELS];
+  int i;
+  for(i = 0; i < CHAOS_NUMBER_OF_CHANNELS; i++) {
+    w[i] = WEIGHT_GET(weights, i);
+  }
+  chaos_multichannel_set_channel_weights(w, epoch);
+}
+
+static int
+is_pending(const uint16_t round_count) {
+  return 0;
+}
+
+static void
+round_begin(const uint16_t round_count, const uint8_t id) {
+  /* never pending: no rounds of our own */
+}
+
+static void
+rider_round_begin(const uint16_t round_count, uint8_t* tx_payload) {
+  hopping_t* tx = (hopping_t*)tx_payload;
+  int i;
+  if(IS_INITIATOR() && collected_valid && round_count % CHAOS_HOPPING_REGENERATION_PERIOD == 0
+      && memcmp(weights, collected, WEIGHTS_LEN) != 0) {
+    /* announce the network-wide picture of the last round as the new weights.
+     * Everybody switches at the end of this round */
+    memcpy(weights, collected, WEIGHTS_LEN);
+    epoch = epoch + 1 ? epoch + 1 : 1;
+    weights_changed = 1;
+  }
+  tx->epoch = epoch;
+  tx->source = IS_INITIATOR() ? SOURCE_INITIATOR : (IS_ROUND_INITIATOR() ? SOURCE_CO_INITIATOR : SOURCE_NODE);
+  memcpy(tx->weights, weights, WEIGHTS_LEN);
+  for(i = 0; i < CHAOS_NUMBER_OF_CHANNELS; i++) {
+    WEIGHT_SET(tx->collected, i, channel_quality(i));
+  }
+}
+
+static chaos_state_t
+process(uint16_t round_count, uint16_t slot_count, chaos_state_t current_state,
+    int chaos_txrx_success, size_t payload_length, uint8_t* rx_payload, uint8_t* tx_payload, uint8_t** app_flags) {
+  hopping_t* tx = (hopping_t*)tx_payload;
+  hopping_t* rx = (hopping_t*)rx_payload;
+  uint8_t delta = 0;
+  int i;
+  if(current_state == CHAOS_RX && chaos_txrx_success && payload_length == sizeof(hopping_t)) {
+    if(rx->source > tx->source) {
+      tx->epoch = rx->epoch;
+      tx->source = rx->source;
+      memcpy(tx->weights, rx->weights, WEIGHTS_LEN);
+      delta = 1;
+    }
+    for(i = 0; i < CHAOS_NUMBER_OF_CHANNELS; i++) {
+      uint8_t rx_w = WEIGHT_GET(rx->collected, i);
+      if(rx_w < WEIGHT_GET(tx->collected, i)) {
+        WEIGHT_SET(tx->collected, i, rx_w);
+        delta = 1;
+      }
+    }
+  }
+  return delta ? CHAOS_TX : CHAOS_RX;
+}
+
+static void
+rider_round_end(const uint16_t round_count, const uint8_t* payload) {
+  const hopping_t* result = (const hopping_t*)payload;
+  if(IS_INITIATOR()) {
+    memcpy(collected, result->collected, WEIGHTS_LEN);
+    collected_valid = 1;
+  } else if(result->source != SOURCE_NODE
+      && (result->epoch != epoch || memcmp(weights, result->weights, WEIGHTS_LEN) != 0)) {
+    /* follow whoever started the round, even to an older epoch */
+    epoch = result->epoch;
+    memcpy(weights, result->weights, WEIGHTS_LEN);
+    weights_changed = 1;
+  }
+  /* regenerate here, outside of the slots */
+  if(weights_changed) {
+    apply_weights();
+    weights_changed = 0;
+  }
+}
+
+uint8_t
+hopping_get_epoch(void) {
+  return epoch;
+}
+
+#else /* CHAOS_HOPPING_REGENERATION && CHAOS_MULTI_CHANNEL */
+
+uint8_t hopping_get_epoch(void) { return 0; }
+
+#endif /* CHAOS_HOPPING_REGENERATION && CHAOS_MULTI_CHANNEL */
@@ -43,6 +43,7 @@
 
 #include "chaos.h"
 #include "chaos-random-generator.h"
+#include "chaos-termination.h"
 #include "chaos-control.h"
 #include "node.h"
 #include "join.h"
@@ -100,7 +101,7 @@ volatile join_debug_t join_debug_var = {0,0,0,0,0};
 #define FLAG_SUM(node_count)  ((((node_count) - 1) / 8 * 0xFF) + LAST_FLAGS(node_count))
 
 typedef struct __attribute__((packed)) {
-  uint8_t node_count;
+  node_index_t node_count;
   union {
     uint8_t commit_field;
     struct{
@@ -258,7 +259,7 @@ static inline int merge_lists(join_t* join_tx, join_t* join_rx) {
 }
 
 //only executed by initiator
-static inline void add_node(join_t* join_tx, uint8_t i, uint8_t chaos_node_count_before_commit) {
+static inline void add_node(join_t* join_tx, int i, node_index_t chaos_node_count_before_commit) {
   //search and check if this is node is already added
   LEDS_ON(LEDS_RED);
 //  node_index_t j;
@@ -295,7 +296,7 @@ static inline void add_node(join_t* join_tx, uint8_t i, uint8_t chaos_node_count
 //only executed by initiator
 static inline void commit(join_t* join_tx) {
   COOJA_DEBUG_STR("commit!");
-  uint8_t chaos_node_count_before_commit = chaos_node_count;
+  node_index_t chaos_node_count_before_commit = chaos_node_count;
   int i;
   for (i = 0; i < join_tx->slot_count; i++) {
     if( !join_tx->index[i] && join_tx->slot[i] ){
@@ -511,6 +512,9 @@ static chaos_state_t process(uint16_t round_count, uint16_t slot,
       if( delta ){
         tx_count_complete = 0; //restart final flood if a neighbor is behind
       }
+      if( complete ){
+        CHAOS_TERMINATION_RX_COMPLETE(delta);
+      }
       if ( complete ){
         if( next_state == CHAOS_TX ){
           tx_count_complete++;
@@ -519,7 +523,7 @@ static chaos_state_t process(uint16_t round_count, uint16_t slot,
     } else {
       invalid_rx_count++;
       if( tx_timeout_enabled ){
-        unsigned short threshold = chaos_random_generator_fast() % (CHAOS_RESTART_MAX - CHAOS_RESTART_MIN) + CHAOS_RESTART_MIN;
+        unsigned short threshold = CHAOS_RESTART_THRESHOLD();
         if( invalid_rx_count > threshold ){
           next_state = CHAOS_TX;
           invalid_rx_count = 0;
@@ -530,7 +534,7 @@ static chaos_state_t process(uint16_t round_count, uint16_t slot,
       }
     }
   } else if( current_state == CHAOS_TX ){
-    if ( complete && tx_count_complete >= N_TX_COMPLETE ){
+    if ( complete && tx_count_complete >= CHAOS_N_TX_COMPLETE() ){
       next_state = CHAOS_OFF;
     }
   }
@@ -43,7 +43,7 @@
 #include "chaos-control.h"
 
 typedef uint16_t node_id_t;
-typedef uint8_t node_index_t;
+typedef chaos_node_index_t node_index_t;
 
 extern const chaos_app_t join;
 
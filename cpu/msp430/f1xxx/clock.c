@@ -63,11 +63,14 @@ read_tar(void)
 /*---------------------------------------------------------------------------*/
 ISR(TIMERA1, timera1)
 {
+  uint16_t taiv;
+
   ENERGEST_ON(ENERGEST_TYPE_IRQ);
 
   watchdog_start();
 
-  if(TAIV == 2) {
+  taiv = TAIV;
+  if(taiv == 2) {
 
     /* HW timer bug fix: Interrupt handler called before TR==CCR.
      * Occurs when timer state is toggled between STOP and CONT. */
@@ -101,6 +104,10 @@ ISR(TIMERA1, timera1)
     }
 
   }
+  else if(taiv == 4) {
+    /* CCR2 compare, only enabled by a low-power wait (CLOCK_ARCH_CCR2_WAKEUP): wake up */
+    LPM4_EXIT;
+  }
   /*  if(process_nevents() >= 0) {
     LPM4_EXIT;
     }*/
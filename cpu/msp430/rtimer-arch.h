@@ -60,6 +60,13 @@
 #define T_TICK_CAPTURE_REG TACCR2
 #endif
 
+#if CONTIKI_TARGET_SKY
+/* the f1xxx clock interrupt leaves LPM on a Timer A CCR2 compare */
+#define CLOCK_ARCH_CCR2_WAKEUP 1
+#else
+#define CLOCK_ARCH_CCR2_WAKEUP 0
+#endif
+
 /* used in RTIMER_DCO_SYNC() */
 extern volatile rtimer_clock_t rtimer_ref, dco_ref;
 
@@ -155,8 +155,8 @@ ALWAYS_INLINE void cc2420_set_channel_fast(int c);
 #define NETSTACK_RADIO_set_txpower(X)           cc2420_set_txpower(X)
 #define NETSTACK_RADIO_set_cca_threshold(X)     cc2420_set_cca_threshold(X)
 #define NETSTACK_RADIO_fast_send(X,S)     			cc2420_fast_send(X,S)
-#define NETSTACK_RADIO_fast_rx(sfd_vht, round_synced, app_id, association, rx_packet, slot_length) \
-        cc2420_fast_rx(sfd_vht, round_synced, app_id, association, rx_packet, slot_length)
+#define NETSTACK_RADIO_fast_rx(sfd_vht, round_synced, app_id, association, rx_packet, slot_length, round_guard) \
+        cc2420_fast_rx(sfd_vht, round_synced, app_id, association, rx_packet, slot_length, round_guard)
 #define NETSTACK_RADIO_rx_byte_available()     	cc2420_rx_byte_available()
 #define NETSTACK_RADIO_get_rx_byte(B)     			CC2420_GET_RX_BYTE((B))
 #define NETSTACK_RADIO_flushrx()     						cc2420_flushrx()
@@ -331,7 +331,7 @@ static cc2420_rx_chaos_packet(rtimer_clock_t begin, int rx, vht_clock_t* sfd_vht
     // read the first byte (i.e., the len field) from the RXFIFO
     NETSTACK_RADIO_get_rx_byte(rx_packet[bytes_cnt++]);
     uint8_t max_packet_size = sizeof(chaos_header_t) + FOOTER_LEN + LLSEC802154_MIC_LENGTH + CHAOS_MAX_PAYLOAD_LEN;
-    if((rx_packet[0] < sizeof(chaos_header_t) + FOOTER_LEN + LLSEC802154_MIC_LENGTH) || rx_packet[0] > max_packet_size ) {
+    if((rx_packet[0] < CHAOS_HEADER_MIN_LEN + FOOTER_LEN + LLSEC802154_MIC_LENGTH) || rx_packet[0] > max_packet_size ) {
       //COOJA_DEBUG_STR("length error");
       COOJA_DEBUG_STRX("length err ", max_packet_size, 3);
       NETSTACK_RADIO_flushrx();
@@ -450,7 +450,7 @@ static cc2420_rx_chaos_packet(rtimer_clock_t begin, int rx, vht_clock_t* sfd_vht
 }
 
 static ALWAYS_INLINE int
-cc2420_fast_rx(vht_clock_t* sfd_vht, int round_synced, uint8_t app_id, uint8_t association, uint8_t * const rx_packet, rtimer_clock_t slot_length)
+cc2420_fast_rx(vht_clock_t* sfd_vht, int round_synced, uint8_t app_id, uint8_t association, uint8_t * const rx_packet, rtimer_clock_t slot_length, rtimer_clock_t round_guard)
 {
 
   COOJA_DEBUG_STR("0");
@@ -469,7 +469,7 @@ cc2420_fast_rx(vht_clock_t* sfd_vht, int round_synced, uint8_t app_id, uint8_t a
   if( round_synced ){
     BUSYWAIT_UNTIL((rx = CC2420_SFD_IS_1), (DCO_TO_RTIMER(SFD_DETECTION_TIME_MIN) + (RX_GUARD_TIME)));
   } else if( !round_synced && !association ){
-    BUSYWAIT_UNTIL((rx = CC2420_SFD_IS_1), DCO_TO_RTIMER(SFD_DETECTION_TIME_MIN) + (ROUND_GUARD_TIME));
+    BUSYWAIT_UNTIL((rx = CC2420_SFD_IS_1), DCO_TO_RTIMER(SFD_DETECTION_TIME_MIN) + (round_guard));
   } else if( association ){
     BUSYWAIT_UNTIL((rx = CC2420_SFD_IS_1), (slot_length));
   }
@@ -0,0 +1,293 @@
+/*******************************************************************************
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017 Beshr Al Nahas and Olaf Landsiedel.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+/**
+ * \file
+ *         A2-Synchrotron - host test for chaos-log-decode.
+ *         Writes a log of a few rounds in the binary format on stdout,
+ *         or with -t the same log as the text lines chaos-log.c prints
+ *         without CHAOS_LOG_BINARY. "make test" decodes the first and
+ *         compares it with the second.
+ *         Covers deltas across the frames of a round, flags that were
+ *         not stored, the round number wrap and a frame lost on the line.
+ * \author
+ *         Beshr Al Nahas <beshr@chalmers.se>
+ *         Olaf Landsiedel <olafl@chalmers.se>
+ *
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+/* keep in sync with core/net/mac/chaos/chaos-log.c, built with CHAOS_LOG_FLAGS and CHAOS_USE_SRC_ID */
+#define CHAOS_LOG_BINARY_VERSION 2
+#define CHAOS_LOG_BINARY_F_FLAGS 0x04
+#define CHAOS_LOG_BINARY_F_SRC_ID 0x08
+#define CHAOS_LOG_BINARY_F_RESET 0x80
+#define LOG_APP_FLAGS_LEN 4
+#define CHAOS_LOG_BINARY_FLAGS_MISSING (LOG_APP_FLAGS_LEN + 1)
+#define SLIP_END 0xc0
+#define SLIP_ESC 0xdb
+#define SLIP_ESC_END 0xdc
+#define SLIP_ESC_ESC 0xdd
+
+/* chaos_state_t and chaos_rx_status_t */
+#define CRX 1
+#define CTX 2
+#define ROK 1
+#define SFD 2
+#define RTO(BYTES) (9 + (BYTES))
+
+typedef struct {
+  uint8_t state;
+  uint8_t rx_status;
+  uint16_t round_number;
+  uint16_t slot_number;
+  uint8_t channel;
+  long go; /* DCO ticks */
+  long sfd;
+  const uint8_t *flags; /* NULL: not stored */
+  uint16_t src_id;
+} record_t;
+
+static const uint8_t f_a[] = { 0x01, 0x00, 0x00, 0x00 };
+static const uint8_t f_b[] = { 0x03, 0x00, 0x00, 0x00 };
+static const uint8_t f_c[] = { 0x03, 0x80, 0x00, 0x00 };
+/* 0xc0 and 0xdb need SLIP escapes */
+static const uint8_t f_d[] = { 0xc0, 0x00, 0xdb, 0x01 };
+static const uint8_t f_e[] = { 0x00, 0x00, 0x00, 0x00 };
+
+/* round 100 in two frames, the first record of the second without flags */
+static const record_t frame_1[] = {
+  { CTX, ROK, 100, 0, 26, 12, -3, f_a, 3 },
+  { CRX, ROK, 100, 1, 15, 5, 2, f_b, 7 },
+};
+static const record_t frame_2[] = {
+  { CRX, SFD, 100, 2, 20, -1, 0, NULL, 7 },
+  { CRX, ROK, 100, 3, 26, 7, 1, f_c, 200 },
+};
+/* after dropped logs: round 65535 wraps to 0 within the frame */
+static const record_t frame_3[] = {
+  { CRX, RTO(3), 65535, 0, 11, 0, 0, f_d, 3 },
+  { CTX, ROK, 0, 0, 12, 2, -2, f_d, 3 },
+  { CRX, ROK, 0, 1, 13, 300, -300, f_e, 129 },
+};
+/* truncated on the line: the decoder must skip it and the next one of the round */
+static const record_t frame_4[] = {
+  { CRX, ROK, 0, 2, 14, 4, 4, f_a, 5 },
+};
+static const record_t frame_5[] = {
+  { CRX, ROK, 0, 3, 15, 1, 1, f_b, 5 },
+};
+/* a new round resets the deltas */
+static const record_t frame_6[] = {
+  { CTX, ROK, 1, 5, 16, 9, -9, f_c, 3 },
+};
+
+static int text_mode;
+
+/* binary output, bytes after truncate_at (>= 0) are lost */
+static int truncate_at = -1, out_count;
+
+static void
+log_putchar(int c)
+{
+  if(truncate_at < 0 || out_count++ < truncate_at) {
+    putchar(c);
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/* the encoder of chaos-log.c */
+static struct {
+  uint16_t round_number;
+  uint16_t slot_number;
+  uint8_t app_flags[LOG_APP_FLAGS_LEN];
+} log_binary_last;
+static uint8_t log_binary_reset = 1;
+
+static void
+log_put_byte(uint8_t b)
+{
+  if(b == SLIP_END) {
+    log_putchar(SLIP_ESC);
+    log_putchar(SLIP_ESC_END);
+  } else if(b == SLIP_ESC) {
+    log_putchar(SLIP_ESC);
+    log_putchar(SLIP_ESC_ESC);
+  } else {
+    log_putchar(b);
+  }
+}
+
+static void
+log_put_varint(uint32_t v)
+{
+  while(v >= 0x80) {
+    log_put_byte((uint8_t)v | 0x80);
+    v >>= 7;
+  }
+  log_put_byte((uint8_t)v);
+}
+
+static void
+log_put_zigzag(int32_t v)
+{
+  log_put_varint(((uint32_t)v << 1) ^ (uint32_t)(v >> 31));
+}
+
+static void
+log_put_dco_delta(long t)
+{
+  log_put_varint(t < 0 ? (uint32_t)-t << 1 | 1 : (uint32_t)t << 1);
+}
+
+static void
+log_binary_frame_begin(const record_t *first)
+{
+  uint8_t fields = CHAOS_LOG_BINARY_F_FLAGS | CHAOS_LOG_BINARY_F_SRC_ID;
+  if(log_binary_reset || first->round_number != log_binary_last.round_number) {
+    fields |= CHAOS_LOG_BINARY_F_RESET;
+    memset(&log_binary_last, 0, sizeof(log_binary_last));
+    log_binary_reset = 0;
+  }
+  log_putchar(SLIP_END);
+  log_put_byte(CHAOS_LOG_BINARY_VERSION);
+  log_put_byte(fields);
+  log_put_varint(LOG_APP_FLAGS_LEN);
+}
+
+static void
+log_binary_txrx(const record_t *log)
+{
+  log_put_byte(log->state << 4 | log->rx_status);
+  log_put_zigzag((int32_t)log->round_number - log_binary_last.round_number);
+  if(log->round_number != log_binary_last.round_number) {
+    log_binary_last.slot_number = 0;
+  }
+  log_put_zigzag((int32_t)log->slot_number - log_binary_last.slot_number);
+  log_binary_last.round_number = log->round_number;
+  log_binary_last.slot_number = log->slot_number;
+  log_put_byte(log->channel);
+  log_put_dco_delta(log->go);
+  log_put_dco_delta(log->sfd);
+  if(log->flags == NULL) {
+    log_put_varint(CHAOS_LOG_BINARY_FLAGS_MISSING);
+  } else {
+    uint16_t i, changed = 0, last_index = 0;
+    for(i = 0; i < LOG_APP_FLAGS_LEN; i++) {
+      changed += log->flags[i] != log_binary_last.app_flags[i];
+    }
+    log_put_varint(changed);
+    for(i = 0; i < LOG_APP_FLAGS_LEN; i++) {
+      if(log->flags[i] != log_binary_last.app_flags[i]) {
+        log_put_varint(i - last_index);
+        log_put_byte(log->flags[i]);
+        last_index = i;
+        log_binary_last.app_flags[i] = log->flags[i];
+      }
+    }
+  }
+  log_put_varint(log->src_id);
+}
+
+/*---------------------------------------------------------------------------*/
+/* the text log of chaos-log.c */
+static void
+log_text_txrx(const record_t *log)
+{
+  static const char *state_strings[] = { "INI ", "cRX ", "cTX " };
+  static const char *rx_status_strings[] = { "rNA ", "rOK ", "SFD " };
+  int i;
+  printf("{rd-%u st-%u ch-%u} ", log->round_number, log->slot_number, log->channel);
+  printf("%s", state_strings[log->state]);
+  if(log->rx_status >= RTO(0)) {
+    printf("rTO %u ", log->rx_status - RTO(0));
+  } else {
+    printf("%s", rx_status_strings[log->rx_status]);
+  }
+  printf("gd %s%lu ", log->go < 0 ? "-" : "", (unsigned long)(log->go < 0 ? -log->go : log->go));
+  printf("sd %s%lu ", log->sfd < 0 ? "-" : "", (unsigned long)(log->sfd < 0 ? -log->sfd : log->sfd));
+  printf("ap ");
+  for(i = 0; i < LOG_APP_FLAGS_LEN; i++) {
+    if(log->flags != NULL) {
+      printf("%02x", log->flags[i]);
+    } else {
+      printf("??");
+    }
+  }
+  printf(" si %u\n", log->src_id);
+}
+
+/*---------------------------------------------------------------------------*/
+/* lost: number of bytes of the frame that reach the decoder, -1 for all.
+ * decoded: the decoder can restore the records */
+static void
+put_frame(const record_t *records, int n, int lost, int decoded)
+{
+  int i;
+  if(text_mode) {
+    for(i = 0; i < n && decoded; i++) {
+      log_text_txrx(&records[i]);
+    }
+    return;
+  }
+  truncate_at = lost;
+  out_count = 0;
+  log_binary_frame_begin(&records[0]);
+  for(i = 0; i < n; i++) {
+    log_binary_txrx(&records[i]);
+  }
+  truncate_at = -1;
+  log_putchar(SLIP_END);
+}
+
+#define PUT_FRAME(F, LOST, DECODED) put_frame((F), sizeof(F) / sizeof((F)[0]), (LOST), (DECODED))
+
+int
+main(int argc, char **argv)
+{
+  text_mode = argc > 1 && strcmp(argv[1], "-t") == 0;
+
+  printf("CHAOS: text before the first frame\n");
+  PUT_FRAME(frame_1, -1, 1);
+  PUT_FRAME(frame_2, -1, 1);
+  printf("CHAOS:! logs dropped 2\n");
+  log_binary_reset = 1;
+  PUT_FRAME(frame_3, -1, 1);
+  PUT_FRAME(frame_4, 6, 0);
+  PUT_FRAME(frame_5, -1, 0);
+  PUT_FRAME(frame_6, -1, 1);
+  printf("CHAOS: text after the last frame\n");
+  return 0;
+}
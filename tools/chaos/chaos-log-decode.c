@@ -0,0 +1,274 @@
+/*******************************************************************************
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2017 Beshr Al Nahas and Olaf Landsiedel.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+/**
+ * \file
+ *         A2-Synchrotron - host decoder for the binary slot log (CHAOS_LOG_BINARY).
+ *         Reads the serial output on stdin, passes text through and
+ *         replaces every log frame with the text lines chaos-log.c prints
+ *         without CHAOS_LOG_BINARY.
+ *         Usage: chaos-log-decode < serial-output > log.txt
+ * \author
+ *         Beshr Al Nahas <beshr@chalmers.se>
+ *         Olaf Landsiedel <olafl@chalmers.se>
+ *
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdlib.h>
+
+/* keep in sync with core/net/mac/chaos/chaos-log.c */
+#define CHAOS_LOG_BINARY_VERSION 2
+#define CHAOS_LOG_BINARY_F_BLACK_LIST 0x01
+#define CHAOS_LOG_BINARY_F_JOIN 0x02
+#define CHAOS_LOG_BINARY_F_FLAGS 0x04
+#define CHAOS_LOG_BINARY_F_SRC_ID 0x08
+#define CHAOS_LOG_BINARY_F_RESET 0x80
+#define SLIP_END 0xc0
+#define SLIP_ESC 0xdb
+#define SLIP_ESC_END 0xdc
+#define SLIP_ESC_ESC 0xdd
+
+#define MAX_FRAME_LEN (1 << 20)
+#define MAX_FLAGS_LEN 256
+
+/* keep in sync with chaos_state_t and chaos_rx_status_t in core/net/mac/chaos/chaos.h */
+static const char *state_strings[] = { "INI ", "cRX ", "cTX ", "OFF ", "sRX ", "sTX " };
+static const char *rx_status_strings[] = { "rNA ", "rOK ", "SFD ", "HDR ", "CRC ", "MIC ", "ERR ", "rNK ", "rNK " };
+#define CHAOS_RX_TIMEOUT 9
+
+static uint8_t frame[MAX_FRAME_LEN];
+
+/* delta reference, carried across the frames of a round */
+static struct {
+  int valid;
+  uint16_t round_number;
+  uint16_t slot_number;
+  uint8_t flags[MAX_FLAGS_LEN];
+} last;
+
+/* text of the frame being decoded, printed once the whole frame decoded */
+static char *text;
+static size_t text_len, text_size;
+
+static void
+out(const char *fmt, ...)
+{
+  va_list ap;
+  int n;
+  va_start(ap, fmt);
+  n = vsnprintf(text + text_len, text_size - text_len, fmt, ap);
+  va_end(ap);
+  if(n >= 0 && (size_t)n >= text_size - text_len) {
+    text_size = 2 * (text_len + n + 1);
+    text = realloc(text, text_size);
+    if(text == NULL) {
+      perror("chaos-log-decode");
+      exit(1);
+    }
+    va_start(ap, fmt);
+    n = vsnprintf(text + text_len, text_size - text_len, fmt, ap);
+    va_end(ap);
+  }
+  if(n > 0) {
+    text_len += n;
+  }
+}
+
+struct reader {
+  const uint8_t *data;
+  size_t len;
+  size_t pos;
+  int error;
+};
+
+static uint8_t
+get_byte(struct reader *r)
+{
+  if(r->pos >= r->len) {
+    r->error = 1;
+    return 0;
+  }
+  return r->data[r->pos++];
+}
+
+static uint32_t
+get_varint(struct reader *r)
+{
+  uint32_t v = 0;
+  int shift = 0;
+  uint8_t b;
+  do {
+    b = get_byte(r);
+    v |= (uint32_t)(b & 0x7f) << shift;
+    shift += 7;
+  } while((b & 0x80) && !r->error && shift < 35);
+  return v;
+}
+
+static int32_t
+get_zigzag(struct reader *r)
+{
+  uint32_t v = get_varint(r);
+  return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+/* returns 0 if the frame could not be decoded */
+static int
+decode_records(const uint8_t *data, size_t len)
+{
+  struct reader r = { data, len, 0, 0 };
+  uint8_t fields;
+  uint32_t flags_len = 0, i;
+  uint8_t *flags = last.flags;
+
+  if(get_byte(&r) != CHAOS_LOG_BINARY_VERSION) {
+    return 0;
+  }
+  fields = get_byte(&r);
+  if(fields & CHAOS_LOG_BINARY_F_FLAGS) {
+    flags_len = get_varint(&r);
+    if(flags_len > MAX_FLAGS_LEN) {
+      return 0;
+    }
+  }
+  if(fields & CHAOS_LOG_BINARY_F_RESET) {
+    memset(&last, 0, sizeof(last));
+    last.valid = 1;
+  } else if(!last.valid) {
+    /* the reference was lost with an earlier frame: wait for the next reset */
+    return 0;
+  }
+  while(!r.error && r.pos < r.len) {
+    uint8_t state_rx = get_byte(&r);
+    uint8_t state = state_rx >> 4, rx_status = state_rx & 0xf;
+    int32_t round_delta = get_zigzag(&r);
+    uint32_t go, sfd;
+    if(round_delta != 0) {
+      last.slot_number = 0;
+    }
+    last.round_number += round_delta;
+    last.slot_number += get_zigzag(&r);
+    out("{rd-%u st-%u ch-%u} ", last.round_number, last.slot_number, get_byte(&r));
+    out("%s", state < sizeof(state_strings) / sizeof(state_strings[0]) ? state_strings[state] : "UNK ");
+    out("%s", rx_status >= CHAOS_RX_TIMEOUT ? "rTO " : rx_status_strings[rx_status]);
+    if(rx_status >= CHAOS_RX_TIMEOUT) {
+      out("%u ", rx_status - CHAOS_RX_TIMEOUT);
+    }
+    go = get_varint(&r);
+    sfd = get_varint(&r);
+    out("gd %s%lu ", (go & 1) ? "-" : "", (unsigned long)(go >> 1));
+    out("sd %s%lu ", (sfd & 1) ? "-" : "", (unsigned long)(sfd >> 1));
+    if(fields & CHAOS_LOG_BINARY_F_BLACK_LIST) {
+      uint32_t local = get_varint(&r);
+      uint32_t merged = get_varint(&r);
+      uint32_t committed = get_varint(&r);
+      out("bl %x bm %x bc %x ", (unsigned)local, (unsigned)merged, (unsigned)committed);
+    }
+    if(fields & CHAOS_LOG_BINARY_F_JOIN) {
+      uint8_t join = get_byte(&r);
+      out("js %u/%01u/%01u ", join >> 2, (join >> 1) & 1, join & 1);
+    }
+    if(fields & CHAOS_LOG_BINARY_F_FLAGS) {
+      uint32_t changed = get_varint(&r), index = 0;
+      /* flags length + 1: not stored on the node */
+      int missing = changed == flags_len + 1;
+      for(i = 0; i < changed && !missing && !r.error; i++) {
+        index += get_varint(&r);
+        if(index >= flags_len) {
+          return 0;
+        }
+        flags[index] = get_byte(&r);
+      }
+      out("ap ");
+      for(i = 0; i < flags_len; i++) {
+        if(missing) {
+          out("??");
+        } else {
+          out("%02x", flags[i]);
+        }
+      }
+    }
+    if(fields & CHAOS_LOG_BINARY_F_SRC_ID) {
+      out(" si %u", (unsigned)get_varint(&r));
+    }
+    out("\n");
+  }
+  return !r.error;
+}
+
+static int
+decode_frame(const uint8_t *data, size_t len)
+{
+  text_len = 0;
+  if(!decode_records(data, len)) {
+    /* no partial records of a truncated frame */
+    last.valid = 0;
+    return 0;
+  }
+  fwrite(text, 1, text_len, stdout);
+  return 1;
+}
+
+int
+main(void)
+{
+  int c, in_frame = 0, escaped = 0;
+  size_t len = 0;
+
+  while((c = getchar()) != EOF) {
+    if(c == SLIP_END) {
+      if(in_frame && len > 0 && !decode_frame(frame, len)) {
+        fprintf(stderr, "chaos-log-decode: dropped a malformed or out of sync frame of %lu bytes\n", (unsigned long)len);
+      }
+      /* an empty frame means we were out of sync: treat this END as a frame start */
+      in_frame = !in_frame || len == 0;
+      len = 0;
+      escaped = 0;
+    } else if(!in_frame) {
+      putchar(c);
+    } else if(escaped) {
+      escaped = 0;
+      if(len < MAX_FRAME_LEN) {
+        frame[len++] = (c == SLIP_ESC_END) ? SLIP_END : (c == SLIP_ESC_ESC) ? SLIP_ESC : c;
+      }
+    } else if(c == SLIP_ESC) {
+      escaped = 1;
+    } else if(len < MAX_FRAME_LEN) {
+      frame[len++] = c;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+# Copyright (c) 2017 Beshr Al Nahas and Olaf Landsiedel.
+# All rights reserved. Licensed under the BSD 3-Clause License, see LICENSE.
+#
+# A2-Synchrotron - turns the slot logs of all nodes of a Cooja run into one
+# Chrome trace (open it in chrome://tracing or https://ui.perfetto.dev).
+#
+# Input: the Cooja mote output saved to a file ("time<TAB>ID:n<TAB>message",
+# time formatted as [h:]mm:ss.mmm or in ms), or a test script log
+# ("time_us:n:message"). The nodes need CHAOS_DEBUG_PRINTF for the slot logs
+# and CHAOS_TIMELINE for the "{rd N tl}" round lines (app, slots, slot length).
+#
+# Output, one process per node:
+#   - one event per slot (TX, or the RX outcome) with round, slot, channel,
+#     go/SFD deltas and the number of set flags,
+#   - a "flags" counter, to see where a flood stalls,
+#   - instant events when a node switches between RX and TX and when it
+#     reaches the most flags of the round.
+# Rounds are aligned on the Cooja time of the earliest round report, so
+# slots are exact within a round and approximate across rounds.
+#
+# Usage: chaos-timeline.py [--slot-us N] cooja.log > trace.json
+
+import argparse
+import collections
+import json
+import re
+import sys
+
+COOJA_LINE = re.compile(r'^(\S+)\s+ID:(\d+)\s+(.*)$')
+SCRIPT_LINE = re.compile(r'^(\d+):(\d+):(.*)$')
+SLOT_LINE = re.compile(r'\{rd-(\d+) st-(\d+) ch-(\d+)\} (\w+) (\w+) (?:(\d+) )?gd (-?\d+) sd (-?\d+)(.*)$')
+ROUND_LINE = re.compile(r'\{rd (\d+) tl\} (\S+) (\d+) (\d+)')
+FLAGS_FIELD = re.compile(r'ap ([0-9a-f?]+)')
+
+TX_STATES = ('cTX', 'sTX')
+RX_NAMES = {'rOK': 'RX ok', 'SFD': 'RX no SFD', 'HDR': 'RX header error', 'CRC': 'RX CRC error',
+            'MIC': 'RX MIC error', 'ERR': 'RX error', 'rTO': 'RX timeout', 'rNA': 'RX', 'rNK': 'RX other'}
+COLORS = {'TX': 'thread_state_running', 'RX ok': 'good', 'RX timeout': 'grey'}
+
+
+def parse_time_us(text, script_log):
+  if script_log:
+    return int(text)
+  if ':' not in text:
+    return int(float(text) * 1000)
+  parts = [float(p) for p in text.split(':')]
+  seconds = 0.0
+  for p in parts:
+    seconds = seconds * 60 + p
+  return int(seconds * 1000000)
+
+
+def parse(lines):
+  slots = []  # (node, round, slot, fields)
+  rounds = {}  # round -> dict(app, slots, slot_us, report_us)
+  for line in lines:
+    line = line.rstrip('\r\n')
+    m = COOJA_LINE.match(line)
+    script_log = False
+    if not m:
+      m = SCRIPT_LINE.match(line)
+      script_log = True
+    if not m:
+      continue
+    try:
+      t = parse_time_us(m.group(1), script_log)
+    except ValueError:
+      continue
+    node, message = int(m.group(2)), m.group(3)
+    s = SLOT_LINE.search(message)
+    if s:
+      flags = FLAGS_FIELD.search(s.group(9))
+      flag_count = None
+      if flags and '?' not in flags.group(1):
+        flag_count = bin(int(flags.group(1), 16)).count('1') if flags.group(1) else 0
+      slots.append((t, node, int(s.group(1)), int(s.group(2)), {
+          'ch': int(s.group(3)), 'state': s.group(4), 'rx': s.group(5),
+          'gd': int(s.group(7)), 'sd': int(s.group(8)), 'flags': flag_count}))
+      continue
+    r = ROUND_LINE.search(message)
+    if r:
+      rd = int(r.group(1))
+      info = rounds.setdefault(rd, {'app': r.group(2), 'slots': 0, 'slot_us': int(r.group(4)), 'report_us': t})
+      info['slots'] = max(info['slots'], int(r.group(3)))
+      info['report_us'] = min(info['report_us'], t)
+  return slots, rounds
+
+
+def round_starts(slots, rounds, slot_us):
+  """Start of every round: earliest report minus the round length"""
+  first_seen = {}
+  max_slot = collections.defaultdict(int)
+  for t, node, rd, st, _ in slots:
+    first_seen[rd] = min(first_seen.get(rd, t), t)
+    max_slot[rd] = max(max_slot[rd], st)
+  starts = {}
+  for rd in set(first_seen) | set(rounds):
+    info = rounds.get(rd)
+    if info:
+      starts[rd] = (info['report_us'] - info['slots'] * info['slot_us'], info['slot_us'], info['app'])
+    else:
+      starts[rd] = (first_seen[rd] - (max_slot[rd] + 1) * slot_us, slot_us, None)
+  return starts
+
+
+def trace(slots, rounds, slot_us):
+  starts = round_starts(slots, rounds, slot_us)
+  events = []
+  for node in sorted(set(s[1] for s in slots)):
+    events.append({'name': 'process_name', 'ph': 'M', 'pid': node, 'args': {'name': 'node %u' % node}})
+    events.append({'name': 'process_sort_index', 'ph': 'M', 'pid': node, 'args': {'sort_index': node}})
+  for rd, (start, _, app) in sorted(starts.items()):
+    events.append({'name': 'rd %u %s' % (rd, app or ''), 'ph': 'i', 's': 'g', 'ts': start, 'pid': 0, 'tid': 0})
+  round_max_flags = collections.defaultdict(int)
+  for _, node, rd, _, f in slots:
+    if f['flags'] is not None:
+      round_max_flags[rd] = max(round_max_flags[rd], f['flags'])
+  last_state = {}
+  complete = set()
+  for _, node, rd, st, f in sorted(slots, key=lambda s: (s[1], s[2], s[3])):
+    start, length, _ = starts[rd]
+    ts = start + st * length
+    tx = f['state'] in TX_STATES
+    name = 'TX' if tx else RX_NAMES.get(f['rx'], 'RX')
+    event = {'name': name, 'cat': 'slot', 'ph': 'X', 'ts': ts, 'dur': length, 'pid': node, 'tid': 1,
+             'args': {'round': rd, 'slot': st, 'channel': f['ch'], 'go delta': f['gd'], 'sfd delta': f['sd'],
+                      'flags': f['flags']}}
+    if name in COLORS:
+      event['cname'] = COLORS[name]
+    elif not tx and f['rx'] != 'rNA':
+      event['cname'] = 'bad'
+    events.append(event)
+    if f['flags'] is not None:
+      events.append({'name': 'flags', 'ph': 'C', 'ts': ts, 'pid': node, 'args': {'flags': f['flags']}})
+      if f['flags'] == round_max_flags[rd] and (node, rd) not in complete:
+        complete.add((node, rd))
+        events.append({'name': 'most flags', 'ph': 'i', 's': 't', 'ts': ts, 'pid': node, 'tid': 1})
+    key = (node, rd)
+    if key in last_state and last_state[key] != tx:
+      events.append({'name': 'to TX' if tx else 'to RX', 'ph': 'i', 's': 't', 'ts': ts, 'pid': node, 'tid': 1})
+    last_state[key] = tx
+  return {'traceEvents': events, 'displayTimeUnit': 'ms'}
+
+
+def main():
+  parser = argparse.ArgumentParser(description='Chrome trace of the A2-Synchrotron slot logs of a Cooja run')
+  parser.add_argument('log', nargs='?', type=argparse.FileType('r'), default=sys.stdin)
+  parser.add_argument('-o', '--output', type=argparse.FileType('w'), default=sys.stdout)
+  parser.add_argument('--slot-us', type=int, default=4000,
+                      help='slot length for rounds without a "{rd N tl}" line (default 4000)')
+  args = parser.parse_args()
+  slots, rounds = parse(args.log)
+  json.dump(trace(slots, rounds, args.slot_us), args.output)
+
+
+if __name__ == '__main__':
+  main()